@@ -128,6 +128,13 @@ const Sprite *Animation::GetSprite() const
 
 
 
+const string &Animation::SpriteName() const
+{
+	return spriteName;
+}
+
+
+
 // Set or get the color swizzle.
 void Animation::SetSwizzle(int swizzle)
 {
@@ -152,7 +159,7 @@ Animation::Frame Animation::Get(int step) const
 	int frames = sprite->Frames();
 	if(frames <= 1)
 	{
-		frame.first = sprite->Texture();
+		frame.first = sprite->GetRegion();
 		return frame;
 	}
 	
@@ -171,7 +178,7 @@ Animation::Frame Animation::Get(int step) const
 	{
 		if(!repeat && step >= frames - 1)
 		{
-			frame.first = sprite->Texture(frames - 1);
+			frame.first = sprite->GetRegion(frames - 1);
 			frame.fade = 0.f;
 		}
 		else
@@ -179,13 +186,13 @@ Animation::Frame Animation::Get(int step) const
 			step %= (frames + delay);
 			if(step >= frames)
 			{
-				frame.first = sprite->Texture(0);
+				frame.first = sprite->GetRegion(0);
 				frame.fade = 0.f;
 			}
 			else
 			{
-				frame.first = sprite->Texture(step);
-				frame.second = sprite->Texture(step + 1);
+				frame.first = sprite->GetRegion(step);
+				frame.second = sprite->GetRegion(step + 1);
 			}
 		}
 	}
@@ -193,7 +200,7 @@ Animation::Frame Animation::Get(int step) const
 	{
 		if(!repeat && step >= 2 * (frames - 1))
 		{
-			frame.first = sprite->Texture(0);
+			frame.first = sprite->GetRegion(0);
 			frame.fade = 0.f;
 		}
 		else
@@ -201,18 +208,18 @@ Animation::Frame Animation::Get(int step) const
 			step %= 2 * (frames - 1) + delay;
 			if(step < frames - 1)
 			{
-				frame.first = sprite->Texture(step);
-				frame.second = sprite->Texture(step + 1);
+				frame.first = sprite->GetRegion(step);
+				frame.second = sprite->GetRegion(step + 1);
 			}
 			else if(step < 2 * (frames - 1))
 			{
 				step = 2 * (frames - 1) - step;
-				frame.first = sprite->Texture(step);
-				frame.second = sprite->Texture(step - 1);
+				frame.first = sprite->GetRegion(step);
+				frame.second = sprite->GetRegion(step - 1);
 			}
 			else
 			{
-				frame.first = sprite->Texture(0);
+				frame.first = sprite->GetRegion(0);
 				frame.fade = 0.f;
 			}
 		}
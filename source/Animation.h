@@ -13,13 +13,13 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef ANIMATION_H_
 #define ANIMATION_H_
 
-#include <cstdint>
+#include "Sprite.h"
+
 #include <string>
 
 class DataNode;
 class DataWriter;
 class Mask;
-class Sprite;
 
 
 
@@ -32,8 +32,8 @@ class Animation {
 public:
 	class Frame {
 	public:
-		uint32_t first = 0;
-		uint32_t second = 0;
+		Sprite::Region first;
+		Sprite::Region second;
 		float fade = 0.f;
 	};
 	
@@ -55,8 +55,9 @@ public:
 	// Get the characteristics of the sprite.
 	int Width() const;
 	int Height() const;
-	// Get the sprite itself.
+	// Get the sprite itself, or the name it was loaded with.
 	const Sprite *GetSprite() const;
+	const std::string &SpriteName() const;
 	
 	// Set or get the color swizzle.
 	void SetSwizzle(int swizzle);
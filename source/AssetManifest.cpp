@@ -0,0 +1,235 @@
+/* AssetManifest.cpp
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "AssetManifest.h"
+
+#include "DataFile.h"
+#include "DataNode.h"
+#include "DataWriter.h"
+#include "Files.h"
+#include "StartupProfile.h"
+
+#include <ctime>
+#include <map>
+#include <set>
+#include <thread>
+#include <utility>
+
+using namespace std;
+
+namespace {
+	// Everything in one directory tree. Paths are stored in the order that
+	// they were listed, so that the manifest lists them in the same order as
+	// Files::RecursiveList() would.
+	class Tree {
+	public:
+		// When this tree was listed.
+		time_t listed = 0;
+		// Every directory in the tree (starting with the root itself), and its
+		// modification time. If the root does not exist, its time is zero.
+		vector<pair<string, time_t>> directories;
+		// Every file in the tree, and its size.
+		vector<pair<string, int64_t>> files;
+	};
+	
+	map<string, Tree> trees;
+	// Lookup tables for every file and directory in any of the trees.
+	map<string, int64_t> sizes;
+	set<string> directories;
+	
+	
+	string ManifestPath()
+	{
+		return Files::Config() + "assets.txt";
+	}
+	
+	
+	// Check whether no directory in the given tree has changed since it was
+	// listed. A directory changed in the same second that it was listed might
+	// have changed after it was listed, so in that case it must be listed again.
+	bool IsUnchanged(const Tree &tree)
+	{
+		if(tree.directories.empty())
+			return false;
+		for(const pair<string, time_t> &it : tree.directories)
+			if(it.second >= tree.listed || Files::Timestamp(it.first) != it.second)
+				return false;
+		return true;
+	}
+	
+	
+	void List(const string &root, Tree *tree)
+	{
+		StartupProfile::Phase phase("list directory", root);
+		tree->listed = time(nullptr);
+		tree->directories.clear();
+		tree->files.clear();
+		Files::RecursiveList(root, &tree->files, &tree->directories);
+	}
+	
+	
+	// Get the tree that the given path is in, if any.
+	const Tree *Find(const string &path)
+	{
+		for(const auto &it : trees)
+			if(!path.compare(0, it.first.length(), it.first))
+				return &it.second;
+		return nullptr;
+	}
+}
+
+
+
+// Load the manifest of the given directory trees, listing any of them that
+// have changed (or that were not in the saved manifest) again.
+void AssetManifest::Init(const vector<string> &roots)
+{
+	trees.clear();
+	sizes.clear();
+	directories.clear();
+	for(string root : roots)
+	{
+		if(root.empty() || root.back() != '/')
+			root += '/';
+		trees[root];
+	}
+	
+	// Paths in the saved manifest are all relative to their tree's root.
+	{
+		StartupProfile::Phase phase("read asset manifest");
+		DataFile file(ManifestPath());
+		for(const DataNode &node : file)
+		{
+			if(node.Token(0) != "root" || node.Size() < 3)
+				continue;
+			auto it = trees.find(node.Token(1));
+			if(it == trees.end())
+				continue;
+			
+			const string &root = it->first;
+			Tree &tree = it->second;
+			tree.listed = node.Value(2);
+			for(const DataNode &child : node)
+			{
+				if(child.Token(0) == "directory" && child.Size() >= 3)
+					tree.directories.emplace_back(root + child.Token(1), child.Value(2));
+				else if(child.Token(0) == "file" && child.Size() >= 3)
+					tree.files.emplace_back(root + child.Token(1), child.Value(2));
+			}
+		}
+	}
+	
+	// Each tree is independent of the others, so all the trees that changed
+	// can be listed at once.
+	vector<thread> threads;
+	for(auto &it : trees)
+		if(!IsUnchanged(it.second))
+			threads.emplace_back(&List, it.first, &it.second);
+	for(thread &t : threads)
+		t.join();
+	
+	for(const auto &it : trees)
+	{
+		for(const pair<string, time_t> &directory : it.second.directories)
+			if(directory.second)
+				directories.insert(directory.first);
+		for(const pair<string, int64_t> &file : it.second.files)
+			sizes[file.first] = file.second;
+	}
+	if(threads.empty())
+		return;
+	
+	DataWriter out(ManifestPath());
+	for(const auto &it : trees)
+	{
+		const string &root = it.first;
+		out.Write("root", root, static_cast<int64_t>(it.second.listed));
+		out.BeginChild();
+		{
+			for(const pair<string, time_t> &directory : it.second.directories)
+				out.Write("directory", directory.first.substr(root.length()), static_cast<int64_t>(directory.second));
+			for(const pair<string, int64_t> &file : it.second.files)
+				out.Write("file", file.first.substr(root.length()), file.second);
+		}
+		out.EndChild();
+	}
+}
+
+
+
+vector<string> AssetManifest::ListDirectories(string directory)
+{
+	if(directory.empty() || directory.back() != '/')
+		directory += '/';
+	const Tree *tree = Find(directory);
+	if(!tree)
+		return Files::ListDirectories(directory);
+	
+	vector<string> list;
+	for(const pair<string, time_t> &it : tree->directories)
+	{
+		const string &path = it.first;
+		if(path.length() > directory.length() && !path.compare(0, directory.length(), directory)
+				&& path.find('/', directory.length()) == path.length() - 1)
+			list.push_back(path);
+	}
+	return list;
+}
+
+
+
+vector<string> AssetManifest::RecursiveList(const string &directory)
+{
+	vector<string> list;
+	RecursiveList(directory, &list);
+	return list;
+}
+
+
+
+void AssetManifest::RecursiveList(string directory, vector<string> *list)
+{
+	if(directory.empty() || directory.back() != '/')
+		directory += '/';
+	const Tree *tree = Find(directory);
+	if(!tree)
+	{
+		Files::RecursiveList(directory, list);
+		return;
+	}
+	
+	for(const pair<string, int64_t> &it : tree->files)
+		if(!it.first.compare(0, directory.length(), directory))
+			list->push_back(it.first);
+}
+
+
+
+bool AssetManifest::Exists(const string &path)
+{
+	if(path.empty() || (!Find(path) && !Find(path + '/')))
+		return Files::Exists(path);
+	
+	return sizes.count(path) || directories.count(path.back() == '/' ? path : path + '/');
+}
+
+
+
+// Get the size of the given file as of when its directory was listed.
+int64_t AssetManifest::Size(const string &path)
+{
+	auto it = sizes.find(path);
+	if(it != sizes.end())
+		return it->second;
+	
+	return Find(path) ? 0 : Files::Size(path);
+}
@@ -0,0 +1,50 @@
+/* AssetManifest.h
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef ASSET_MANIFEST_H_
+#define ASSET_MANIFEST_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+
+// Class which keeps a list of every file in the game's resource directories and
+// plugins, so that they do not all need to be listed again each time the game
+// starts. The list is saved in the config folder, along with the modification
+// time of every directory in it; adding, removing, or renaming a file changes
+// the time of the directory that it is in. Any directory tree in which that
+// time has changed is listed again, and all the trees that need to be listed
+// are listed at once, in separate threads. For any path that is not in one of
+// the trees in the manifest, each function just asks the file system instead.
+class AssetManifest {
+public:
+	// Load the manifest of the given directory trees, listing any of them that
+	// have changed (or that were not in the saved manifest) again.
+	static void Init(const std::vector<std::string> &roots);
+	
+	// These work the same as the functions of the same names in Files.
+	static std::vector<std::string> ListDirectories(std::string directory);
+	static std::vector<std::string> RecursiveList(const std::string &directory);
+	static void RecursiveList(std::string directory, std::vector<std::string> *list);
+	static bool Exists(const std::string &path);
+	
+	// Get the size of the given file as of when its directory was listed. A
+	// file that is changed in place does not change its directory's time, so
+	// only use this where an out of date size does no harm.
+	static int64_t Size(const std::string &path);
+};
+
+
+
+#endif
@@ -0,0 +1,131 @@
+/* AtlasPacker.cpp
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "AtlasPacker.h"
+
+using namespace std;
+
+
+
+// Each page is pageSize by pageSize pixels, and every image is surrounded by
+// the given number of pixels of empty space.
+AtlasPacker::AtlasPacker(int pageSize, int padding)
+	: pageSize(pageSize), padding(padding)
+{
+}
+
+
+
+// Find a place for an image of the given size. If it does not fit on any
+// page, a new page is added. Returns false if the image is larger than a
+// page can hold.
+bool AtlasPacker::Add(int width, int height, Slot &slot)
+{
+	if(width <= 0 || height <= 0)
+		return false;
+	if(width + 2 * padding > pageSize || height + 2 * padding > pageSize)
+		return false;
+	
+	for(Page &page : pages)
+		if(Add(page, width, height, slot))
+		{
+			slot.page = &page - &pages.front();
+			return true;
+		}
+	
+	pages.emplace_back();
+	if(!Add(pages.back(), width, height, slot))
+		return false;
+	slot.page = pages.size() - 1;
+	return true;
+}
+
+
+
+// Mark the given slot as no longer in use. Space is only reclaimed once
+// every slot on a page has been removed; the page is then reused.
+void AtlasPacker::Remove(const Slot &slot)
+{
+	if(slot.page < 0 || slot.page >= static_cast<int>(pages.size()))
+		return;
+	
+	Page &page = pages[slot.page];
+	if(page.count && !--page.count)
+	{
+		page.shelves.clear();
+		page.y = 0;
+	}
+}
+
+
+
+int AtlasPacker::PageSize() const
+{
+	return pageSize;
+}
+
+
+
+int AtlasPacker::Pages() const
+{
+	return pages.size();
+}
+
+
+
+// Get the number of slots in use on the given page.
+int AtlasPacker::Count(int page) const
+{
+	if(page < 0 || page >= static_cast<int>(pages.size()))
+		return 0;
+	return pages[page].count;
+}
+
+
+
+bool AtlasPacker::Add(Page &page, int width, int height, Slot &slot)
+{
+	int paddedWidth = width + 2 * padding;
+	int paddedHeight = height + 2 * padding;
+	
+	// Find the shelf that wastes the least vertical space. Don't use a shelf
+	// that is much taller than this image, because that would waste the space
+	// above it for the entire length of the shelf.
+	Shelf *best = nullptr;
+	for(Shelf &shelf : page.shelves)
+	{
+		if(shelf.height < paddedHeight || shelf.height > 2 * paddedHeight)
+			continue;
+		if(shelf.x + paddedWidth > pageSize)
+			continue;
+		if(!best || shelf.height < best->height)
+			best = &shelf;
+	}
+	
+	// If no existing shelf works, start a new one.
+	if(!best)
+	{
+		if(page.y + paddedHeight > pageSize)
+			return false;
+		page.shelves.push_back(Shelf{page.y, paddedHeight, 0});
+		page.y += paddedHeight;
+		best = &page.shelves.back();
+	}
+	
+	slot.x = best->x + padding;
+	slot.y = best->y + padding;
+	slot.width = width;
+	slot.height = height;
+	best->x += paddedWidth;
+	++page.count;
+	return true;
+}
@@ -0,0 +1,87 @@
+/* AtlasPacker.h
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef ATLAS_PACKER_H_
+#define ATLAS_PACKER_H_
+
+#include <vector>
+
+
+
+// Class that decides where to place small images within a set of fixed-size
+// square "pages," so that many images can share a single texture. Images are
+// placed in horizontal "shelves" as they arrive, which works well when many
+// images have similar heights (e.g. all the frames of one animation). This
+// class only does the bookkeeping; it does not touch OpenGL at all.
+class AtlasPacker {
+public:
+	// The location of an image within the atlas.
+	class Slot {
+	public:
+		int page = -1;
+		int x = 0;
+		int y = 0;
+		int width = 0;
+		int height = 0;
+	};
+	
+	
+public:
+	// Each page is pageSize by pageSize pixels, and every image is surrounded by
+	// the given number of pixels of empty space.
+	AtlasPacker(int pageSize, int padding = 1);
+	
+	// Find a place for an image of the given size. If it does not fit on any
+	// page, a new page is added. Returns false if the image is larger than a
+	// page can hold.
+	bool Add(int width, int height, Slot &slot);
+	// Mark the given slot as no longer in use. Space is only reclaimed once
+	// every slot on a page has been removed; the page is then reused.
+	void Remove(const Slot &slot);
+	
+	int PageSize() const;
+	int Pages() const;
+	// Get the number of slots in use on the given page.
+	int Count(int page) const;
+	
+	
+private:
+	class Shelf {
+	public:
+		int y;
+		int height;
+		// The first unused x coordinate on this shelf.
+		int x;
+	};
+	
+	class Page {
+	public:
+		std::vector<Shelf> shelves;
+		// The first y coordinate not used by any shelf.
+		int y = 0;
+		int count = 0;
+	};
+	
+	
+private:
+	bool Add(Page &page, int width, int height, Slot &slot);
+	
+	
+private:
+	int pageSize;
+	int padding;
+	std::vector<Page> pages;
+};
+
+
+
+#endif
@@ -12,10 +12,12 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Audio.h"
 
+#include "AssetManifest.h"
 #include "Files.h"
 #include "Point.h"
 #include "Random.h"
 #include "Sound.h"
+#include "StartupProfile.h"
 
 #ifndef __APPLE__
 #include <AL/al.h>
@@ -27,6 +29,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include <algorithm>
 #include <cmath>
+#include <iostream>
 #include <map>
 #include <mutex>
 #include <set>
@@ -59,8 +62,37 @@ namespace {
 		unsigned source = 0;
 	};
 	
+	// A source that is playing a streamed sound has a small ring of buffers
+	// queued on it instead of a single buffer holding the entire sound. Each
+	// time the audio is updated, any buffers it has finished playing are
+	// refilled with the next part of the sound and queued up again.
+	class Stream {
+	public:
+		Stream(const Sound *sound, unsigned source);
+		
+		// Refill and requeue any buffers that the source has finished with.
+		void Update();
+		// Stop looping: play the buffers that are already queued, then stop.
+		void EndLoop();
+		// Stop playing and give back this stream's buffers.
+		void Release();
+		
+	private:
+		// Fill the given buffer with the next chunk of the sound, and queue it.
+		// Returns false if the end of the sound has already been reached.
+		bool Queue(unsigned buffer);
+		
+	private:
+		const Sound *sound = nullptr;
+		unsigned source = 0;
+		size_t position = 0;
+		bool isLooping = false;
+		vector<unsigned> buffers;
+	};
+	
 	void Load();
 	string Name(const string &path);
+	void EndStream(unsigned source);
 	
 	
 	mutex audioMutex;
@@ -79,8 +111,22 @@ namespace {
 	vector<unsigned> endingSources;
 	unsigned maxSources = 255;
 	
+	// Streamed sounds, indexed by the source that is playing them.
+	map<unsigned, Stream> streams;
+	vector<unsigned> recycledBuffers;
+	unsigned streamBufferCount = 0;
+	const size_t STREAM_BUFFERS = 4;
+	const size_t STREAM_CHUNK = 32 * 1024;
+	
+	// Sound files waiting to be loaded, and the threads that are loading them.
+	// The queue is serviced from the back, so that sounds in plugins are loaded
+	// before (and therefore override) any sound with the same name in the base
+	// game or in an earlier plugin.
 	vector<string> loadQueue;
-	thread loadThread;
+	vector<thread> loadThreads;
+	set<string> loadedNames;
+	size_t totalFiles = 0;
+	size_t loadedFiles = 0;
 	
 	Point listener;
 	Point listenerVelocity;
@@ -111,10 +157,21 @@ void Audio::Init(const vector<string> &sources)
 	
 	mainThreadID = this_thread::get_id();
 	
-	for(const string &source : sources)
-		Files::RecursiveList(source + "sounds/", &loadQueue);
-	if(!loadQueue.empty())
-		loadThread = thread(&Load);
+	{
+		StartupProfile::Phase phase("list sound files");
+		for(const string &source : sources)
+			AssetManifest::RecursiveList(source + "sounds/", &loadQueue);
+	}
+	totalFiles = loadQueue.size();
+	if(loadQueue.empty())
+		return;
+	
+	// Reading a sound is mostly waiting on the disk, so use a small pool of
+	// loader threads rather than a single one.
+	size_t threadCount = max(1u, min(thread::hardware_concurrency(), 4u));
+	threadCount = min(threadCount, loadQueue.size());
+	for(size_t i = 0; i < threadCount; ++i)
+		loadThreads.emplace_back(&Load);
 }
 
 
@@ -124,12 +181,12 @@ double Audio::Progress()
 {
 	unique_lock<mutex> lock(audioMutex);
 	
-	if(loadQueue.empty())
+	if(loadedFiles >= totalFiles)
 		return 1.;
 	
-	double done = sounds.size();
-	double total = done + loadQueue.size();
-	return done / total;
+	// Report progress per file: a file only counts once it has been fully
+	// loaded, not when a loader thread begins working on it.
+	return static_cast<double>(loadedFiles) / static_cast<double>(totalFiles);
 }
 
 
@@ -187,7 +244,7 @@ void Audio::Play(const Sound *sound)
 // "listener". This will make it softer and change the left / right balance.
 void Audio::Play(const Sound *sound, const Point &position)
 {
-	if(!sound || !sound->Buffer() || !volume)
+	if(!sound || !(sound->Buffer() || sound->IsStreamed()) || !volume)
 		return;
 	
 	if(this_thread::get_id() == mainThreadID)
@@ -209,6 +266,10 @@ void Audio::Step()
 	if(this_thread::get_id() != mainThreadID)
 		return;
 	
+	// Top up the buffers of any sounds that are being streamed.
+	for(auto &it : streams)
+		it.second.Update();
+	
 	vector<Source> newSources;
 	// For each sound that is looping, see if it is going to continue. For other
 	// sounds, check if they are done playing.
@@ -226,6 +287,9 @@ void Audio::Step()
 			else
 			{
 				alSourcei(source.ID(), AL_LOOPING, false);
+				auto sit = streams.find(source.ID());
+				if(sit != streams.end())
+					sit->second.EndLoop();
 				endingSources.push_back(source.ID());
 			}
 		}
@@ -237,7 +301,10 @@ void Audio::Step()
 			if(state == AL_PLAYING)
 				newSources.push_back(source);
 			else
+			{
+				EndStream(source.ID());
 				recycledSources.push_back(source.ID());
+			}
 		}
 	}
 	// These sources were looping and are now wrapping up a loop.
@@ -253,10 +320,15 @@ void Audio::Step()
 			alGetSourcef(*it, AL_GAIN, &gain);
 			gain = max(0.f, gain - .05f);
 			alSourcef(*it, AL_GAIN, gain);
+			// Once it is silent, there is no need to play the rest of it. The
+			// source will be recycled the next time through.
+			if(!gain)
+				alSourceStop(*it);
 			++it;
 		}
 		else
 		{
+			EndStream(*it);
 			recycledSources.push_back(*it);
 			it = endingSources.erase(it);
 		}
@@ -287,6 +359,8 @@ void Audio::Step()
 		}
 		sources.emplace_back(it.first, source);
 		sources.back().Move(it.second);
+		if(it.first->IsStreamed())
+			streams.emplace(source, Stream(it.first, source));
 		alSourcePlay(source);
 	}
 	queue.clear();
@@ -294,19 +368,63 @@ void Audio::Step()
 
 
 
+// Print how much memory is used by sounds that are loaded into buffers, and
+// how much by sounds that are streamed instead.
+void Audio::PrintMemoryReport()
+{
+	unique_lock<mutex> lock(audioMutex);
+	
+	size_t residentCount = 0;
+	size_t residentBytes = 0;
+	size_t streamedCount = 0;
+	size_t streamedBytes = 0;
+	for(const auto &it : sounds)
+	{
+		if(it.second.IsStreamed())
+		{
+			++streamedCount;
+			streamedBytes += it.second.Size();
+		}
+		else if(it.second.Buffer())
+		{
+			++residentCount;
+			residentBytes += it.second.Size();
+		}
+	}
+	size_t bufferBytes = streamBufferCount * STREAM_CHUNK;
+	
+	cout << "audio" << '\t' << "sounds" << '\t' << "bytes" << '\n';
+	cout << "resident" << '\t' << residentCount << '\t' << residentBytes << '\n';
+	cout << "streamed (on disk)" << '\t' << streamedCount << '\t' << streamedBytes << '\n';
+	cout << "stream buffers" << '\t' << streamBufferCount << '\t' << bufferBytes << '\n';
+	cout << "total in memory" << '\t' << '\t' << (residentBytes + bufferBytes) << '\n';
+	cout.flush();
+}
+
+
+
 // Shut down the audio system (because we're about to quit).
 void Audio::Quit()
 {
 	unique_lock<mutex> lock(audioMutex);
 	if(!loadQueue.empty())
 		loadQueue.clear();
-	if(loadThread.joinable())
+	if(!loadThreads.empty())
 	{
 		lock.unlock();
-		loadThread.join();
+		for(thread &t : loadThreads)
+			t.join();
 		lock.lock();
+		loadThreads.clear();
 	}
 	
+	for(auto &it : streams)
+		it.second.Release();
+	streams.clear();
+	for(unsigned id : recycledBuffers)
+		alDeleteBuffers(1, &id);
+	recycledBuffers.clear();
+	
 	for(const Source &source : sources)
 	{
 		alSourceStop(source.ID());
@@ -329,7 +447,8 @@ void Audio::Quit()
 	for(const auto &it : sounds)
 	{
 		ALuint id = it.second.Buffer();
-		alDeleteBuffers(1, &id);
+		if(id)
+			alDeleteBuffers(1, &id);
 	}
 	sounds.clear();
 	
@@ -371,7 +490,9 @@ namespace {
 		alSourcef(source, AL_REFERENCE_DISTANCE, 1.);
 		alSourcef(source, AL_ROLLOFF_FACTOR, 1.);
 		alSourcef(source, AL_MAX_DISTANCE, 100.);
-		alSourcei(source, AL_LOOPING, sound->IsLooping());
+		// Streamed sounds handle looping themselves, by wrapping around to the
+		// start of the sound when refilling their buffers.
+		alSourcei(source, AL_LOOPING, sound->IsLooping() && !sound->IsStreamed());
 		alSourcei(source, AL_BUFFER, sound->Buffer());
 	}
 	
@@ -402,32 +523,132 @@ namespace {
 	
 	
 	
-	void Load()
+	Stream::Stream(const Sound *sound, unsigned source)
+		: sound(sound), source(source), isLooping(sound->IsLooping())
+	{
+		for(size_t i = 0; i < STREAM_BUFFERS; ++i)
+		{
+			unsigned buffer = 0;
+			if(recycledBuffers.empty())
+			{
+				alGenBuffers(1, &buffer);
+				if(!buffer)
+					break;
+				++streamBufferCount;
+			}
+			else
+			{
+				buffer = recycledBuffers.back();
+				recycledBuffers.pop_back();
+			}
+			buffers.push_back(buffer);
+			Queue(buffer);
+		}
+	}
+	
+	
+	
+	// Refill and requeue any buffers that the source has finished with.
+	void Stream::Update()
+	{
+		ALint processed = 0;
+		alGetSourcei(source, AL_BUFFERS_PROCESSED, &processed);
+		while(processed-- > 0)
+		{
+			ALuint buffer = 0;
+			alSourceUnqueueBuffers(source, 1, &buffer);
+			Queue(buffer);
+		}
+		
+		// If the buffers ran dry before they could be refilled (e.g. because
+		// of a long frame), the source will have stopped. Start it again.
+		ALint state;
+		alGetSourcei(source, AL_SOURCE_STATE, &state);
+		ALint queued = 0;
+		alGetSourcei(source, AL_BUFFERS_QUEUED, &queued);
+		if(state != AL_PLAYING && queued)
+			alSourcePlay(source);
+	}
+	
+	
+	
+	// Stop looping: play the buffers that are already queued, then stop. They
+	// hold more than enough of the sound for it to fade out, and the rest of
+	// the sound may be minutes long, so do not queue any more of it.
+	void Stream::EndLoop()
+	{
+		isLooping = false;
+		position = sound->Size();
+	}
+	
+	
+	
+	// Stop playing and give back this stream's buffers.
+	void Stream::Release()
+	{
+		alSourceStop(source);
+		// Detach all the queued buffers from the source.
+		alSourcei(source, AL_BUFFER, 0);
+		recycledBuffers.insert(recycledBuffers.end(), buffers.begin(), buffers.end());
+		buffers.clear();
+	}
+	
+	
+	
+	// Fill the given buffer with the next chunk of the sound, and queue it.
+	// Returns false if the end of the sound has already been reached.
+	bool Stream::Queue(unsigned buffer)
 	{
-		set<string> loaded;
+		if(position >= sound->Size())
+		{
+			if(!isLooping)
+				return false;
+			position = 0;
+		}
 		
-		string path;
+		// Keep each chunk a whole number of 16-bit samples.
+		size_t bytes = min(STREAM_CHUNK, sound->Size() - position) & ~static_cast<size_t>(1);
+		if(!bytes)
+			return false;
+		alBufferData(buffer, AL_FORMAT_MONO16, sound->Samples() + position, bytes, sound->Frequency());
+		alSourceQueueBuffers(source, 1, &buffer);
+		position += bytes;
+		return true;
+	}
+	
+	
+	
+	void Load()
+	{
 		while(true)
 		{
+			string path;
+			Sound *sound = nullptr;
 			{
 				unique_lock<mutex> lock(audioMutex);
-				// If this is not the first time through, remove the previous item
-				// in the queue. This is a signal that it has been loaded, so we
-				// must not remove it until after loading the file.
-				if(!path.empty() && !loadQueue.empty())
-					loadQueue.pop_back();
 				if(loadQueue.empty())
 					return;
 				path = loadQueue.back();
+				loadQueue.pop_back();
+				
+				// Claim the sound name while holding the lock, so that if the
+				// same sound exists in more than one source only the one that
+				// comes first in the queue order is loaded. The map entry's
+				// address stays valid while other threads add more sounds.
+				string name = Name(path);
+				if(!name.empty() && loadedNames.insert(name).second)
+					sound = &sounds[name];
 			}
 			
 			// Unlock the mutex for the time-intensive part of the loop.
-			string name = Name(path);
-			if(!name.empty() && !loaded.count(name))
+			if(sound)
 			{
-				loaded.insert(name);
-				sounds[name].Load(path);
+				StartupProfile::Phase phase("sound load", path);
+				sound->Load(path);
 			}
+			
+			unique_lock<mutex> lock(audioMutex);
+			++loadedFiles;
 		}
 	}
 	
@@ -449,4 +670,16 @@ namespace {
 		
 		return path.substr(start, end - start);
 	}
+	
+	
+	
+	void EndStream(unsigned source)
+	{
+		auto it = streams.find(source);
+		if(it == streams.end())
+			return;
+		
+		it->second.Release();
+		streams.erase(it);
+	}
 }
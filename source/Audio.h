@@ -63,6 +63,10 @@ public:
 	// this function was called.
 	static void Step();
 	
+	// Print how much memory is used by sounds that are loaded into buffers, and
+	// how much by sounds that are streamed instead.
+	static void PrintMemoryReport();
+	
 	// Shut down the audio system (because we're about to quit).
 	static void Quit();
 };
@@ -0,0 +1,349 @@
+/* BlockCompressor.cpp
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "BlockCompressor.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+namespace {
+	// Bit offsets of the red, green, and blue channels in a BGRA pixel.
+	const int SHIFT[3] = {16, 8, 0};
+	
+	// Copy out the 4x4 block whose top left corner is (x, y). If the block
+	// extends past the edge of the image, repeat the edge pixels.
+	void GetBlock(const uint32_t *pixels, int width, int height, int x, int y, uint32_t block[16])
+	{
+		for(int j = 0; j < 4; ++j)
+		{
+			const uint32_t *row = pixels + min(y + j, height - 1) * width;
+			for(int i = 0; i < 4; ++i)
+				block[4 * j + i] = row[min(x + i, width - 1)];
+		}
+	}
+	
+	// Copy a decoded block into the image, skipping anything past the edge.
+	void PutBlock(const uint32_t block[16], int width, int height, int x, int y, uint32_t *pixels)
+	{
+		for(int j = 0; j < 4 && y + j < height; ++j)
+		{
+			uint32_t *row = pixels + (y + j) * width;
+			for(int i = 0; i < 4 && x + i < width; ++i)
+				row[x + i] = block[4 * j + i];
+		}
+	}
+	
+	int Channel(uint32_t pixel, int channel)
+	{
+		return (pixel >> SHIFT[channel]) & 0xFF;
+	}
+	
+	// Convert between 8-bit RGB and 16-bit RGB565 colors.
+	uint16_t To565(const int rgb[3])
+	{
+		return ((rgb[0] * 31 + 127) / 255 << 11)
+			| ((rgb[1] * 63 + 127) / 255 << 5)
+			| ((rgb[2] * 31 + 127) / 255);
+	}
+	
+	void From565(uint16_t color, int rgb[3])
+	{
+		int red = (color >> 11) & 31;
+		int green = (color >> 5) & 63;
+		int blue = color & 31;
+		rgb[0] = (red << 3) | (red >> 2);
+		rgb[1] = (green << 2) | (green >> 4);
+		rgb[2] = (blue << 3) | (blue >> 2);
+	}
+	
+	// Get the colors that a block with the given end points can represent. If
+	// the first color is not greater than the second, a BC1 block represents
+	// only three colors plus transparent black. BC3 blocks always have four.
+	void ColorPalette(uint16_t color0, uint16_t color1, bool alwaysFour, int palette[4][3])
+	{
+		From565(color0, palette[0]);
+		From565(color1, palette[1]);
+		bool isFour = (alwaysFour || color0 > color1);
+		for(int c = 0; c < 3; ++c)
+		{
+			if(isFour)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+			}
+			else
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+	}
+	
+	// Get the alpha values that an alpha block with the given end points can
+	// represent.
+	void AlphaPalette(int alpha0, int alpha1, int palette[8])
+	{
+		palette[0] = alpha0;
+		palette[1] = alpha1;
+		if(alpha0 > alpha1)
+		{
+			for(int i = 1; i < 7; ++i)
+				palette[i + 1] = ((7 - i) * alpha0 + i * alpha1 + 3) / 7;
+		}
+		else
+		{
+			for(int i = 1; i < 5; ++i)
+				palette[i + 1] = ((5 - i) * alpha0 + i * alpha1 + 2) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+	
+	void Write(vector<uint8_t> &out, uint64_t value, int bytes)
+	{
+		for(int i = 0; i < bytes; ++i)
+			out.push_back((value >> (8 * i)) & 0xFF);
+	}
+	
+	uint64_t Read(const uint8_t *in, int bytes)
+	{
+		uint64_t value = 0;
+		for(int i = 0; i < bytes; ++i)
+			value |= static_cast<uint64_t>(in[i]) << (8 * i);
+		return value;
+	}
+	
+	// Encode the colors of a block. The end points are the corners of the
+	// bounding box of the colors, which is a good approximation of the line
+	// through them as long as the channels all increase together. If a channel
+	// decreases as the others increase, its ends are swapped.
+	void EncodeColor(const uint32_t block[16], vector<uint8_t> &out)
+	{
+		int low[3] = {255, 255, 255};
+		int high[3] = {0, 0, 0};
+		int sum[3] = {0, 0, 0};
+		for(int i = 0; i < 16; ++i)
+			for(int c = 0; c < 3; ++c)
+			{
+				int value = Channel(block[i], c);
+				low[c] = min(low[c], value);
+				high[c] = max(high[c], value);
+				sum[c] += value;
+			}
+		
+		// Compare each channel to the one with the widest range.
+		int axis = 0;
+		for(int c = 1; c < 3; ++c)
+			if(high[c] - low[c] > high[axis] - low[axis])
+				axis = c;
+		for(int c = 0; c < 3; ++c)
+		{
+			if(c == axis)
+				continue;
+			int covariance = 0;
+			for(int i = 0; i < 16; ++i)
+				covariance += (16 * Channel(block[i], c) - sum[c]) * (16 * Channel(block[i], axis) - sum[axis]) / 256;
+			if(covariance < 0)
+				swap(low[c], high[c]);
+		}
+		
+		// Pull the end points in slightly, since the extremes are usually only a
+		// single pixel or two and the interpolated colors are used far more.
+		for(int c = 0; c < 3; ++c)
+		{
+			int inset = (high[c] - low[c]) / 16;
+			low[c] += inset;
+			high[c] -= inset;
+		}
+		
+		uint16_t color0 = To565(high);
+		uint16_t color1 = To565(low);
+		if(color0 < color1)
+			swap(color0, color1);
+		
+		uint32_t indices = 0;
+		if(color0 != color1)
+		{
+			int palette[4][3];
+			ColorPalette(color0, color1, true, palette);
+			for(int i = 0; i < 16; ++i)
+			{
+				int best = 0;
+				int bestDistance = 0;
+				for(int p = 0; p < 4; ++p)
+				{
+					int distance = 0;
+					for(int c = 0; c < 3; ++c)
+					{
+						int d = Channel(block[i], c) - palette[p][c];
+						distance += d * d;
+					}
+					if(!p || distance < bestDistance)
+					{
+						best = p;
+						bestDistance = distance;
+					}
+				}
+				indices |= static_cast<uint32_t>(best) << (2 * i);
+			}
+		}
+		Write(out, color0, 2);
+		Write(out, color1, 2);
+		Write(out, indices, 4);
+	}
+	
+	// Encode the alpha values of a block, using all eight interpolated values.
+	void EncodeAlpha(const uint32_t block[16], vector<uint8_t> &out)
+	{
+		int low = 255;
+		int high = 0;
+		for(int i = 0; i < 16; ++i)
+		{
+			int alpha = block[i] >> 24;
+			low = min(low, alpha);
+			high = max(high, alpha);
+		}
+		
+		uint64_t indices = 0;
+		if(high != low)
+		{
+			int palette[8];
+			AlphaPalette(high, low, palette);
+			for(int i = 0; i < 16; ++i)
+			{
+				int alpha = block[i] >> 24;
+				int best = 0;
+				for(int p = 1; p < 8; ++p)
+					if(abs(alpha - palette[p]) < abs(alpha - palette[best]))
+						best = p;
+				indices |= static_cast<uint64_t>(best) << (3 * i);
+			}
+		}
+		out.push_back(high);
+		out.push_back(low);
+		Write(out, indices, 6);
+	}
+	
+	void DecodeColor(const uint8_t *in, bool alwaysFour, uint32_t block[16])
+	{
+		int palette[4][3];
+		uint16_t color0 = Read(in, 2);
+		uint16_t color1 = Read(in + 2, 2);
+		ColorPalette(color0, color1, alwaysFour, palette);
+		bool hasTransparent = (!alwaysFour && color0 <= color1);
+		
+		uint32_t indices = Read(in + 4, 4);
+		for(int i = 0; i < 16; ++i)
+		{
+			int index = (indices >> (2 * i)) & 3;
+			if(hasTransparent && index == 3)
+				block[i] = 0;
+			else
+				block[i] = 0xFF000000 | (palette[index][0] << 16) | (palette[index][1] << 8) | palette[index][2];
+		}
+	}
+	
+	void DecodeAlpha(const uint8_t *in, uint32_t block[16])
+	{
+		int palette[8];
+		AlphaPalette(in[0], in[1], palette);
+		
+		uint64_t indices = Read(in + 2, 6);
+		for(int i = 0; i < 16; ++i)
+		{
+			uint32_t alpha = palette[(indices >> (3 * i)) & 7];
+			block[i] = (block[i] & 0xFFFFFF) | (alpha << 24);
+		}
+	}
+	
+	size_t Blocks(int width, int height)
+	{
+		return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4);
+	}
+}
+
+
+
+// The size of the compressed data for an image of the given size.
+size_t BlockCompressor::BC1Size(int width, int height)
+{
+	return 8 * Blocks(width, height);
+}
+
+
+
+size_t BlockCompressor::BC3Size(int width, int height)
+{
+	return 16 * Blocks(width, height);
+}
+
+
+
+// Compress the given image, appending the blocks to the output.
+void BlockCompressor::EncodeBC1(const uint32_t *pixels, int width, int height, vector<uint8_t> &out)
+{
+	out.reserve(out.size() + BC1Size(width, height));
+	uint32_t block[16];
+	for(int y = 0; y < height; y += 4)
+		for(int x = 0; x < width; x += 4)
+		{
+			GetBlock(pixels, width, height, x, y, block);
+			EncodeColor(block, out);
+		}
+}
+
+
+
+void BlockCompressor::EncodeBC3(const uint32_t *pixels, int width, int height, vector<uint8_t> &out)
+{
+	out.reserve(out.size() + BC3Size(width, height));
+	uint32_t block[16];
+	for(int y = 0; y < height; y += 4)
+		for(int x = 0; x < width; x += 4)
+		{
+			GetBlock(pixels, width, height, x, y, block);
+			EncodeAlpha(block, out);
+			EncodeColor(block, out);
+		}
+}
+
+
+
+// Decompress the given blocks into an image of the given size.
+void BlockCompressor::DecodeBC1(const uint8_t *blocks, int width, int height, uint32_t *pixels)
+{
+	uint32_t block[16];
+	for(int y = 0; y < height; y += 4)
+		for(int x = 0; x < width; x += 4)
+		{
+			DecodeColor(blocks, false, block);
+			PutBlock(block, width, height, x, y, pixels);
+			blocks += 8;
+		}
+}
+
+
+
+void BlockCompressor::DecodeBC3(const uint8_t *blocks, int width, int height, uint32_t *pixels)
+{
+	uint32_t block[16];
+	for(int y = 0; y < height; y += 4)
+		for(int x = 0; x < width; x += 4)
+		{
+			DecodeColor(blocks + 8, true, block);
+			DecodeAlpha(blocks, block);
+			PutBlock(block, width, height, x, y, pixels);
+			blocks += 16;
+		}
+}
@@ -0,0 +1,48 @@
+/* BlockCompressor.h
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef BLOCK_COMPRESSOR_H_
+#define BLOCK_COMPRESSOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+
+// Class for encoding and decoding BC1 (DXT1) and BC3 (DXT5) compressed
+// textures on the CPU. The image is divided into 4x4 blocks, and each block is
+// stored as two 16-bit colors plus a 2-bit index per pixel choosing one of four
+// colors interpolated between them; BC3 adds a separate block of 8-bit alpha
+// values with 3-bit indices. BC1 is only used here for fully opaque images.
+// Pixels are 32-bit BGRA values, the same as in an ImageBuffer. Nothing here
+// depends on OpenGL, so the results can be checked without a graphics context.
+class BlockCompressor {
+public:
+	// The size of the compressed data for an image of the given size.
+	static size_t BC1Size(int width, int height);
+	static size_t BC3Size(int width, int height);
+	
+	// Compress the given image, appending the blocks to the output. Images
+	// whose size is not a multiple of four are padded by repeating the pixels
+	// along their right and bottom edges.
+	static void EncodeBC1(const uint32_t *pixels, int width, int height, std::vector<uint8_t> &out);
+	static void EncodeBC3(const uint32_t *pixels, int width, int height, std::vector<uint8_t> &out);
+	
+	// Decompress the given blocks into an image of the given size.
+	static void DecodeBC1(const uint8_t *blocks, int width, int height, uint32_t *pixels);
+	static void DecodeBC3(const uint8_t *blocks, int width, int height, uint32_t *pixels);
+};
+
+
+
+#endif
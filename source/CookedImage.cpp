@@ -0,0 +1,281 @@
+/* CookedImage.cpp
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "CookedImage.h"
+
+#include "BlockCompressor.h"
+#include "File.h"
+#include "ImageBuffer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+	// Cooked files start with this tag, followed by a version number. The
+	// header and pixels are in the byte order of the machine that cooked them,
+	// so a file from a machine with a different byte order will be rejected
+	// because its version number will not match.
+	const char MAGIC[4] = {'E', 'S', 'T', 'X'};
+	const uint32_t VERSION = 1;
+	
+	// Get the number of bytes needed to store an image of the given size.
+	size_t Size(CookedImage::Format format, int width, int height)
+	{
+		if(format == CookedImage::BC1)
+			return BlockCompressor::BC1Size(width, height);
+		if(format == CookedImage::BC3)
+			return BlockCompressor::BC3Size(width, height);
+		return 4 * static_cast<size_t>(width) * height;
+	}
+
+}
+
+
+
+// Convert the given image, which must already be premultiplied.
+CookedImage *CookedImage::Cook(const ImageBuffer &image, bool mipmap, bool compress)
+{
+	if(!image.Width() || !image.Height())
+		return nullptr;
+	
+	CookedImage *cooked = new CookedImage;
+	cooked->width = image.Width();
+	cooked->height = image.Height();
+	
+	const uint32_t *begin = image.Pixels();
+	const uint32_t *end = begin + image.Width() * image.Height();
+	if(compress)
+	{
+		bool isOpaque = all_of(begin, end, [](uint32_t pixel) { return (pixel >> 24) == 0xFF; });
+		cooked->format = isOpaque ? BC1 : BC3;
+	}
+	
+	// Because the pixels are premultiplied, each mipmap level can be made by
+	// simply averaging the pixels of the level above it.
+	ImageBuffer level(image.Width(), image.Height());
+	copy(begin, end, level.Pixels());
+	while(true)
+	{
+		int width = level.Width();
+		int height = level.Height();
+		cooked->levels.emplace_back();
+		vector<uint8_t> &data = cooked->levels.back();
+		if(cooked->format == BC1)
+			BlockCompressor::EncodeBC1(level.Pixels(), width, height, data);
+		else if(cooked->format == BC3)
+			BlockCompressor::EncodeBC3(level.Pixels(), width, height, data);
+		else
+		{
+			const uint8_t *bytes = reinterpret_cast<const uint8_t *>(level.Pixels());
+			data.assign(bytes, bytes + Size(BGRA, width, height));
+		}
+		
+		if(!mipmap || (width == 1 && height == 1))
+			break;
+		level.ShrinkToHalfSize();
+	}
+	return cooked;
+}
+
+
+
+// Read a cooked image file.
+CookedImage *CookedImage::Read(const string &path)
+{
+	File file(path);
+	if(!file)
+		return nullptr;
+	
+	char magic[4];
+	uint32_t version = 0;
+	int32_t header[4];
+	if(fread(magic, 1, 4, file) != 4 || memcmp(magic, MAGIC, 4))
+		return nullptr;
+	if(fread(&version, sizeof(version), 1, file) != 1 || version != VERSION)
+		return nullptr;
+	if(fread(header, sizeof(header), 1, file) != 1)
+		return nullptr;
+	
+	// Make sure the header is sane before allocating anything.
+	if(header[0] <= 0 || header[1] <= 0 || header[2] < BGRA || header[2] > BC3 || header[3] <= 0 || header[3] > 32)
+		return nullptr;
+	
+	CookedImage *cooked = new CookedImage;
+	cooked->width = header[0];
+	cooked->height = header[1];
+	cooked->format = static_cast<Format>(header[2]);
+	cooked->levels.resize(header[3]);
+	for(int i = 0; i < cooked->Levels(); ++i)
+	{
+		uint32_t size = 0;
+		vector<uint8_t> &data = cooked->levels[i];
+		bool isValid = (fread(&size, sizeof(size), 1, file) == 1
+			&& size == Size(cooked->format, cooked->Width(i), cooked->Height(i)));
+		if(isValid)
+		{
+			data.resize(size);
+			isValid = (fread(&data.front(), 1, size, file) == size);
+		}
+		if(!isValid)
+		{
+			delete cooked;
+			return nullptr;
+		}
+	}
+	return cooked;
+}
+
+
+
+// Read only the dimensions of the full size image from a cooked file.
+bool CookedImage::ReadSize(const string &path, int &width, int &height)
+{
+	Format format = BGRA;
+	int levels = 0;
+	return ReadHeader(path, width, height, format, levels);
+}
+
+
+
+// Read the dimensions, format, and number of mipmap levels from a cooked file.
+bool CookedImage::ReadHeader(const string &path, int &width, int &height, Format &format, int &levels)
+{
+	File file(path);
+	if(!file)
+		return false;
+	
+	char magic[4];
+	uint32_t version = 0;
+	int32_t header[4];
+	if(fread(magic, 1, 4, file) != 4 || memcmp(magic, MAGIC, 4))
+		return false;
+	if(fread(&version, sizeof(version), 1, file) != 1 || version != VERSION)
+		return false;
+	if(fread(header, sizeof(header), 1, file) != 1)
+		return false;
+	if(header[0] <= 0 || header[1] <= 0 || header[2] < BGRA || header[2] > BC3 || header[3] <= 0 || header[3] > 32)
+		return false;
+	
+	width = header[0];
+	height = header[1];
+	format = static_cast<Format>(header[2]);
+	levels = header[3];
+	return true;
+}
+
+
+
+// Write this image to the given path.
+bool CookedImage::Write(const string &path) const
+{
+	File file(path, true);
+	if(!file)
+		return false;
+	
+	int32_t header[4] = {width, height, format, Levels()};
+	bool success = (fwrite(MAGIC, 1, 4, file) == 4);
+	success &= (fwrite(&VERSION, sizeof(VERSION), 1, file) == 1);
+	success &= (fwrite(header, sizeof(header), 1, file) == 1);
+	for(const vector<uint8_t> &data : levels)
+	{
+		uint32_t size = data.size();
+		success &= (fwrite(&size, sizeof(size), 1, file) == 1);
+		success &= (fwrite(&data.front(), 1, size, file) == size);
+	}
+	return success;
+}
+
+
+
+int CookedImage::Width() const
+{
+	return width;
+}
+
+
+
+int CookedImage::Height() const
+{
+	return height;
+}
+
+
+
+CookedImage::Format CookedImage::GetFormat() const
+{
+	return format;
+}
+
+
+
+// Get the number of mipmap levels, and the dimensions and data of each one.
+int CookedImage::Levels() const
+{
+	return levels.size();
+}
+
+
+
+int CookedImage::Width(int level) const
+{
+	return max(1, width >> level);
+}
+
+
+
+int CookedImage::Height(int level) const
+{
+	return max(1, height >> level);
+}
+
+
+
+const vector<uint8_t> &CookedImage::Data(int level) const
+{
+	return levels[level];
+}
+
+
+
+// Drop the full size level of this image, so that it is half as big.
+bool CookedImage::ShrinkToHalfSize()
+{
+	if(levels.size() < 2)
+		return false;
+	
+	width = Width(1);
+	height = Height(1);
+	levels.erase(levels.begin());
+	return true;
+}
+
+
+
+// Get the full size image as uncompressed pixels.
+ImageBuffer *CookedImage::Decode() const
+{
+	if(levels.empty())
+		return nullptr;
+	
+	ImageBuffer *image = new ImageBuffer(width, height);
+	const uint8_t *data = &levels.front().front();
+	if(format == BC1)
+		BlockCompressor::DecodeBC1(data, width, height, image->Pixels());
+	else if(format == BC3)
+		BlockCompressor::DecodeBC3(data, width, height, image->Pixels());
+	else
+		memcpy(image->Pixels(), data, Size(BGRA, width, height));
+	return image;
+}
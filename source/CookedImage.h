@@ -0,0 +1,86 @@
+/* CookedImage.h
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef COOKED_IMAGE_H_
+#define COOKED_IMAGE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ImageBuffer;
+
+
+
+// Class representing an image that has been converted ahead of time into the
+// form it will be uploaded to the GPU in: already premultiplied, optionally
+// with a full chain of mipmaps, and optionally block compressed. Cooked images
+// are stored in a simple binary format that can be read straight into memory,
+// which is much faster than decoding a PNG or JPEG file.
+class CookedImage {
+public:
+	enum Format {
+		// Uncompressed 32-bit BGRA pixels, as in an ImageBuffer.
+		BGRA = 0,
+		// BC1 (DXT1), for images that are fully opaque.
+		BC1 = 1,
+		// BC3 (DXT5), for images with an alpha channel.
+		BC3 = 2
+	};
+	
+	
+public:
+	// Convert the given image, which must already be premultiplied. If
+	// compression is requested, BC1 is used if every pixel is opaque and BC3
+	// otherwise.
+	static CookedImage *Cook(const ImageBuffer &image, bool mipmap, bool compress);
+	// Read a cooked image file. This returns null if the file is missing or is
+	// not a valid cooked image.
+	static CookedImage *Read(const std::string &path);
+	// Read only the dimensions of the full size image from a cooked file.
+	static bool ReadSize(const std::string &path, int &width, int &height);
+	// Read the dimensions, format, and number of mipmap levels from a cooked
+	// file, without reading any of its pixels.
+	static bool ReadHeader(const std::string &path, int &width, int &height, Format &format, int &levels);
+	// Write this image to the given path.
+	bool Write(const std::string &path) const;
+	
+	int Width() const;
+	int Height() const;
+	Format GetFormat() const;
+	
+	// Get the number of mipmap levels, and the dimensions and data of each one.
+	// Level 0 is the full size image.
+	int Levels() const;
+	int Width(int level) const;
+	int Height(int level) const;
+	const std::vector<uint8_t> &Data(int level) const;
+	
+	// Drop the full size level of this image, so that the next mipmap level
+	// becomes the full size. This returns false if there are no mipmaps.
+	bool ShrinkToHalfSize();
+	
+	// Get the full size image as uncompressed pixels, e.g. for creating a
+	// collision mask or for a GPU that does not support block compression.
+	ImageBuffer *Decode() const;
+	
+	
+private:
+	int width = 0;
+	int height = 0;
+	Format format = BGRA;
+	std::vector<std::vector<uint8_t>> levels;
+};
+
+
+
+#endif
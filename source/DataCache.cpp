@@ -0,0 +1,232 @@
+/* DataCache.cpp
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "DataCache.h"
+
+#include "DataFile.h"
+#include "DataNode.h"
+#include "File.h"
+#include "Files.h"
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+using namespace std;
+
+namespace {
+	const char MAGIC[4] = {'E', 'S', 'D', 'C'};
+	const uint32_t VERSION = 1;
+	// This marks the end of the cache, so that a file that was only partly
+	// written will not be used.
+	const char END[4] = {'D', 'O', 'N', 'E'};
+	
+	// Append the raw bytes of a value to the given buffer.
+	template <class Type>
+	void Append(string &out, const Type &value)
+	{
+		out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+	}
+	
+	void Append(string &out, const string &value)
+	{
+		Append<uint32_t>(out, value.size());
+		out += value;
+	}
+	
+	// Class for reading values back out of the cache, making sure that nothing
+	// is read past the end of it.
+	class Reader {
+	public:
+		Reader(const char *it, const char *end) : it(it), end(end) {}
+		
+		template <class Type>
+		bool Get(Type &value)
+		{
+			if(static_cast<size_t>(end - it) < sizeof(value))
+				return false;
+			memcpy(&value, it, sizeof(value));
+			it += sizeof(value);
+			return true;
+		}
+		
+		bool Get(string &value)
+		{
+			uint32_t size = 0;
+			if(!Get(size) || static_cast<size_t>(end - it) < size)
+				return false;
+			value.assign(it, size);
+			it += size;
+			return true;
+		}
+		
+		bool Match(const char (&bytes)[4])
+		{
+			if(end - it < 4 || memcmp(it, bytes, 4))
+				return false;
+			it += 4;
+			return true;
+		}
+	
+	private:
+		const char *it;
+		const char *end;
+	};
+	
+	bool IsSame(const DataNode &a, const DataNode &b)
+	{
+		if(a.Size() != b.Size())
+			return false;
+		for(int i = 0; i < a.Size(); ++i)
+			if(a.Token(i) != b.Token(i))
+				return false;
+		
+		auto it = b.begin();
+		for(const DataNode &child : a)
+		{
+			if(it == b.end() || !IsSame(child, *it))
+				return false;
+			++it;
+		}
+		return (it == b.end());
+	}
+}
+
+
+
+// Load the given files from the cache, if it is up to date.
+bool DataCache::Read(const string &cachePath, const vector<string> &paths, vector<DataFile> &files)
+{
+	files.clear();
+	MappedFile mapped(cachePath);
+	Reader in(mapped.Data(), mapped.Data() + mapped.Size());
+	
+	uint32_t version = 0;
+	uint32_t count = 0;
+	if(!in.Match(MAGIC) || !in.Get(version) || version != VERSION)
+		return false;
+	if(!in.Get(count) || count != paths.size())
+		return false;
+	
+	// Check that every file is the same as when the cache was written.
+	for(const string &path : paths)
+	{
+		string cachedPath;
+		int64_t timestamp = 0;
+		int64_t size = 0;
+		if(!in.Get(cachedPath) || !in.Get(timestamp) || !in.Get(size))
+			return false;
+		if(cachedPath != path || timestamp != Files::Timestamp(path) || size != Files::Size(path))
+			return false;
+	}
+	
+	// The files must all be created up front, so that none of them move once
+	// they are loaded; each DataNode refers to its parent.
+	files.resize(paths.size());
+	for(DataFile &file : files)
+	{
+		uint32_t nodeCount = 0;
+		uint32_t tokenCount = 0;
+		if(!in.Get(nodeCount) || !in.Get(tokenCount))
+			break;
+		if(!nodeCount)
+			continue;
+		
+		shared_ptr<DataNode::Arena> arena = make_shared<DataNode::Arena>();
+		arena->nodes.resize(nodeCount);
+		arena->tokens.resize(tokenCount);
+		bool isValid = true;
+		for(DataNode &node : arena->nodes)
+		{
+			node.arena = arena.get();
+			isValid &= in.Get(node.parent) && in.Get(node.firstChild) && in.Get(node.childCount)
+				&& in.Get(node.firstToken) && in.Get(node.tokenCount);
+			// Make sure no index is out of range.
+			isValid &= (node.parent == DataNode::NONE || node.parent < nodeCount)
+				&& node.firstChild <= nodeCount && node.childCount <= nodeCount - node.firstChild
+				&& node.firstToken <= tokenCount && node.tokenCount <= tokenCount - node.firstToken;
+			if(!isValid)
+				break;
+		}
+		for(DataNode::Arena::Token &token : arena->tokens)
+			if(!isValid || !(isValid = in.Get(token.text)))
+				break;
+		if(!isValid)
+		{
+			files.clear();
+			return false;
+		}
+		file.root = arena->nodes.front();
+	}
+	
+	if(!in.Match(END))
+	{
+		files.clear();
+		return false;
+	}
+	return true;
+}
+
+
+
+// Save the given files, which were parsed from the given paths.
+bool DataCache::Write(const string &cachePath, const vector<string> &paths, const vector<DataFile> &files)
+{
+	if(paths.size() != files.size())
+		return false;
+	
+	string out(MAGIC, 4);
+	Append(out, VERSION);
+	Append<uint32_t>(out, paths.size());
+	for(const string &path : paths)
+	{
+		Append(out, path);
+		Append<int64_t>(out, Files::Timestamp(path));
+		Append<int64_t>(out, Files::Size(path));
+	}
+	
+	for(const DataFile &file : files)
+	{
+		const DataNode::Arena *arena = file.root.arena;
+		Append<uint32_t>(out, arena ? arena->nodes.size() : 0);
+		Append<uint32_t>(out, arena ? arena->tokens.size() : 0);
+		if(!arena)
+			continue;
+		
+		for(const DataNode &node : arena->nodes)
+		{
+			Append(out, node.parent);
+			Append(out, node.firstChild);
+			Append(out, node.childCount);
+			Append(out, node.firstToken);
+			Append(out, node.tokenCount);
+		}
+		for(const DataNode::Arena::Token &token : arena->tokens)
+			Append(out, token.text);
+	}
+	out.append(END, 4);
+	
+	File file(cachePath, true);
+	if(!file)
+		return false;
+	return (fwrite(out.data(), 1, out.size(), file) == out.size());
+}
+
+
+
+// Check whether two parsed files contain exactly the same nodes.
+bool DataCache::IsSame(const DataFile &a, const DataFile &b)
+{
+	return ::IsSame(a.root, b.root);
+}
+
@@ -0,0 +1,41 @@
+/* DataCache.h
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef DATA_CACHE_H_
+#define DATA_CACHE_H_
+
+#include <string>
+#include <vector>
+
+class DataFile;
+
+
+
+// Class for saving the parsed form of all the game's data files, so that the
+// next time the game starts they do not need to be tokenized again. The cache
+// records the path, modification time, and size of every file, and is only
+// used if the list of files and all of those values are exactly the same.
+class DataCache {
+public:
+	// Load the given files from the cache, if it is up to date. If not, this
+	// returns false and leaves the files empty.
+	static bool Read(const std::string &cachePath, const std::vector<std::string> &paths, std::vector<DataFile> &files);
+	// Save the given files, which were parsed from the given paths.
+	static bool Write(const std::string &cachePath, const std::vector<std::string> &paths, const std::vector<DataFile> &files);
+	
+	// Check whether two parsed files contain exactly the same nodes.
+	static bool IsSame(const DataFile &a, const DataFile &b);
+};
+
+
+
+#endif
@@ -14,6 +14,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Files.h"
 
+#include <algorithm>
+#include <cstdint>
+
 using namespace std;
 
 
@@ -68,14 +71,14 @@ void DataFile::Load(istream &in)
 
 
 
-list<DataNode>::const_iterator DataFile::begin() const
+vector<DataNode>::const_iterator DataFile::begin() const
 {
 	return root.begin();
 }
 
 
 
-list<DataNode>::const_iterator DataFile::end() const
+vector<DataNode>::const_iterator DataFile::end() const
 {
 	return root.end();
 }
@@ -84,7 +87,17 @@ list<DataNode>::const_iterator DataFile::end() const
 
 void DataFile::Load(const char *it, const char *end)
 {
-	vector<DataNode *> stack(1, &root);
+	shared_ptr<DataNode::Arena> arena = make_shared<DataNode::Arena>();
+	
+	// First, read the nodes in the order they appear in the file, remembering
+	// each one's parent and where its tokens start. Node 0 is the root.
+	vector<uint32_t> parents(1, DataNode::NONE);
+	vector<uint32_t> tokenStart(1, 0);
+	// Nodes with a missing closing quotation mark are reported once the tree
+	// has been built, so that their traces can be printed.
+	vector<uint32_t> unclosed;
+	
+	vector<uint32_t> stack(1, 0);
 	vector<int> whiteStack(1, -1);
 	
 	for( ; it != end; ++it)
@@ -113,12 +126,12 @@ void DataFile::Load(const char *it, const char *end)
 		}
 		
 		// Add this node as a child of the proper node.
-		list<DataNode> &children = stack.back()->children;
-		children.emplace_back(stack.back());
-		DataNode &node = children.back();
+		uint32_t index = parents.size();
+		parents.push_back(stack.back());
+		tokenStart.push_back(arena->tokens.size());
 		
 		// Remember where in the tree we are.
-		stack.push_back(&node);
+		stack.push_back(index);
 		whiteStack.push_back(white);
 		
 		// Tokenize the line. Skip comments and empty lines.
@@ -137,12 +150,11 @@ void DataFile::Load(const char *it, const char *end)
 			// It ought to be legal to construct a string from an empty iterator
 			// range, but it appears that some libraries do not handle that case
 			// correctly. So:
-			if(start == it)
-				node.tokens.emplace_back();
-			else
-				node.tokens.emplace_back(start, it);
+			arena->tokens.emplace_back();
+			if(start != it)
+				arena->tokens.back().text.assign(start, it);
 			if(isQuoted && *it == '\n')
-				node.PrintTrace("Closing quotation mark is missing:");
+				unclosed.push_back(index);
 			
 			if(*it != '\n')
 			{
@@ -160,4 +172,48 @@ void DataFile::Load(const char *it, const char *end)
 			}
 		}
 	}
+	tokenStart.push_back(arena->tokens.size());
+	
+	// Link each node to its siblings, in order.
+	size_t count = parents.size();
+	vector<uint32_t> firstChild(count, DataNode::NONE);
+	vector<uint32_t> lastChild(count, DataNode::NONE);
+	vector<uint32_t> nextSibling(count, DataNode::NONE);
+	for(uint32_t i = 1; i < count; ++i)
+	{
+		uint32_t parent = parents[i];
+		if(firstChild[parent] == DataNode::NONE)
+			firstChild[parent] = i;
+		else
+			nextSibling[lastChild[parent]] = i;
+		lastChild[parent] = i;
+	}
+	
+	// Now, store the nodes in breadth first order. That way, all the children
+	// of any one node are next to each other.
+	vector<uint32_t> order(1, 0);
+	order.reserve(count);
+	arena->nodes.resize(count);
+	for(size_t i = 0; i < order.size(); ++i)
+	{
+		uint32_t original = order[i];
+		DataNode &node = arena->nodes[i];
+		node.arena = arena.get();
+		node.firstToken = tokenStart[original];
+		node.tokenCount = tokenStart[original + 1] - tokenStart[original];
+		node.firstChild = order.size();
+		for(uint32_t child = firstChild[original]; child != DataNode::NONE; child = nextSibling[child])
+		{
+			arena->nodes[order.size()].parent = i;
+			order.push_back(child);
+		}
+		node.childCount = order.size() - node.firstChild;
+	}
+	root = arena->nodes.front();
+	
+	for(uint32_t index : unclosed)
+	{
+		size_t i = find(order.begin(), order.end(), index) - order.begin();
+		arena->nodes[i].PrintTrace("Closing quotation mark is missing:");
+	}
 }
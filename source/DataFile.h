@@ -16,7 +16,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "DataNode.h"
 
 #include <istream>
-#include <list>
+#include <vector>
 
 
 
@@ -35,8 +35,8 @@ public:
 	void Load(const std::string &path);
 	void Load(std::istream &in);
 	
-	std::list<DataNode>::const_iterator begin() const;
-	std::list<DataNode>::const_iterator end() const;
+	std::vector<DataNode>::const_iterator begin() const;
+	std::vector<DataNode>::const_iterator end() const;
 	
 	
 private:
@@ -45,6 +45,8 @@ private:
 	
 private:
 	DataNode root;
+	
+	friend class DataCache;
 };
 
 
@@ -20,27 +20,31 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 using namespace std;
 
-
-
-DataNode::DataNode(const DataNode *parent)
-	: parent(parent)
-{
-	tokens.reserve(4);
+namespace {
+	// A node that is not part of a file has no children.
+	const vector<DataNode> NO_CHILDREN;
 }
 
+const uint32_t DataNode::NONE;
 
 
+
+// A copy of a node may outlive the file that it came from, so it must share
+// ownership of the arena.
 DataNode::DataNode(const DataNode &other)
-	: children(other.children), tokens(other.tokens)
+	: arena(other.arena), owner(other.owner), parent(other.parent), firstChild(other.firstChild),
+	childCount(other.childCount), firstToken(other.firstToken), tokenCount(other.tokenCount)
 {
+	if(arena && !owner)
+		owner = arena->shared_from_this();
 }
 
 
 
 DataNode &DataNode::operator=(const DataNode &other)
 {
-	children = other.children;
-	tokens = other.tokens;
+	if(this != &other)
+		*this = DataNode(other);
 	return *this;
 }
 
@@ -48,14 +52,14 @@ DataNode &DataNode::operator=(const DataNode &other)
 
 int DataNode::Size() const
 {
-	return tokens.size();
+	return tokenCount;
 }
 
 
 
 const string &DataNode::Token(int index) const
 {
-	return tokens[index];
+	return arena->tokens[firstToken + index].text;
 }
 
 
@@ -63,17 +67,22 @@ const string &DataNode::Token(int index) const
 double DataNode::Value(int index) const
 {
 	// Check for empty strings and out-of-bounds indices.
-	if(static_cast<size_t>(index) >= tokens.size() || tokens[index].empty())
+	if(static_cast<uint32_t>(index) >= tokenCount || Token(index).empty())
 	{
 		PrintTrace("Requested token index (" + to_string(index) + ") is out of bounds:");
 		return 0.;
 	}
 	
+	// If this token has been converted before, the result was saved.
+	const Arena::Token &token = arena->tokens[firstToken + index];
+	if(token.hasValue)
+		return token.value;
+	
 	// Allowed format: "[+-]?[0-9]*[.]?[0-9]*([eE][+-]?[0-9]*)?".
-	const char *it = tokens[index].c_str();
+	const char *it = token.text.c_str();
 	if(*it != '-' && *it != '.' && *it != '+' && !(*it >= '0' && *it <= '9'))
 	{
-		PrintTrace("Cannot convert value \"" + tokens[index] + "\" to a number:");
+		PrintTrace("Cannot convert value \"" + token.text + "\" to a number:");
 		return 0.;
 	}
 	
@@ -112,29 +121,35 @@ double DataNode::Value(int index) const
 		power += sign * exponent;
 	}
 	
-	// Compose the return value.
-	return copysign(value * pow(10., power), sign);
+	// Compose the return value, and remember it.
+	token.value = copysign(value * pow(10., power), sign);
+	token.hasValue = true;
+	return token.value;
 }
 
 
 
 bool DataNode::HasChildren() const
 {
-	return !children.empty();
+	return childCount;
 }
 
 
 
-list<DataNode>::const_iterator DataNode::begin() const
+vector<DataNode>::const_iterator DataNode::begin() const
 {
-	return children.begin();
+	if(!arena)
+		return NO_CHILDREN.begin();
+	return arena->nodes.begin() + firstChild;
 }
 
 
 
-list<DataNode>::const_iterator DataNode::end() const
+vector<DataNode>::const_iterator DataNode::end() const
 {
-	return children.end();
+	if(!arena)
+		return NO_CHILDREN.end();
+	return arena->nodes.begin() + firstChild + childCount;
 }
 
 
@@ -149,15 +164,16 @@ int DataNode::PrintTrace(const string &message) const
 	}
 	
 	int indent = 0;
-	if(parent)
-		indent = parent->PrintTrace() + 2;
-	if(tokens.empty())
+	if(arena && parent != NONE)
+		indent = arena->nodes[parent].PrintTrace() + 2;
+	if(!tokenCount)
 		return indent;
 	
 	string line(indent, ' ');
-	for(const string &token : tokens)
+	for(int i = 0; i < Size(); ++i)
 	{
-		if(&token != &tokens.front())
+		const string &token = Token(i);
+		if(i)
 			line += ' ';
 		bool hasSpace = any_of(token.begin(), token.end(), [](char c) { return isspace(c); });
 		bool hasQuote = any_of(token.begin(), token.end(), [](char c) { return (c == '"'); });
@@ -13,7 +13,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef DATA_NODE_H_
 #define DATA_NODE_H_
 
-#include <list>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -25,33 +26,74 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 // The tokens of a node are separated by white space, with quotation marks being
 // used to group multiple words into a single token. If the token text contains
 // quotation marks, it should be enclosed in backticks instead.
+// All the nodes and tokens of a file are stored together in one "arena," with
+// the children of each node next to each other, so parsing a file takes only a
+// few allocations. Copying a node is cheap, because the copy just shares the
+// arena (and keeps it alive for as long as the copy exists).
 class DataNode {
 public:
-	DataNode(const DataNode *parent = nullptr);
+	DataNode() = default;
 	DataNode(const DataNode &other);
+	DataNode(DataNode &&other) noexcept = default;
 	
 	DataNode &operator=(const DataNode &other);
+	DataNode &operator=(DataNode &&other) noexcept = default;
 	
 	int Size() const;
 	const std::string &Token(int index) const;
 	double Value(int index) const;
 	
 	bool HasChildren() const;
-	std::list<DataNode>::const_iterator begin() const;
-	std::list<DataNode>::const_iterator end() const;
+	std::vector<DataNode>::const_iterator begin() const;
+	std::vector<DataNode>::const_iterator end() const;
 	
 	// Print a message followed by a "trace" of this node and its parents.
 	int PrintTrace(const std::string &message = "") const;
 	
 	
 private:
-	std::list<DataNode> children;
-	std::vector<std::string> tokens;
-	const DataNode *parent = nullptr;
+	class Arena;
+	// This marks a node (the root) that has no parent.
+	static const uint32_t NONE = UINT32_MAX;
 	
+	
+private:
+	// The arena that this node is stored in. Nodes that are stored in the arena
+	// do not own it; any copy made outside of it does.
+	const Arena *arena = nullptr;
+	std::shared_ptr<const Arena> owner;
+	
+	// Indices of this node's parent, and of its children and tokens, within
+	// the arena.
+	uint32_t parent = NONE;
+	uint32_t firstChild = 0;
+	uint32_t childCount = 0;
+	uint32_t firstToken = 0;
+	uint32_t tokenCount = 0;
+	
+	friend class DataCache;
 	friend class DataFile;
 };
 
 
 
+// Storage for all the nodes of one file. Each token's numeric value is only
+// calculated the first time it is asked for.
+class DataNode::Arena : public std::enable_shared_from_this<DataNode::Arena> {
+public:
+	class Token {
+	public:
+		std::string text;
+		mutable double value = 0.;
+		mutable bool hasValue = false;
+	};
+	
+	
+public:
+	std::vector<DataNode> nodes;
+	std::vector<Token> tokens;
+};
+
+
+
 #endif
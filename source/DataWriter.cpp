@@ -14,6 +14,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "DataNode.h"
 #include "Files.h"
+#include "WriteQueue.h"
 
 using namespace std;
 
@@ -23,8 +24,8 @@ const string DataWriter::space = " ";
 
 
 
-DataWriter::DataWriter(const string &path)
-	: path(path), before(&indent)
+DataWriter::DataWriter(const string &path, bool inBackground)
+	: path(path), inBackground(inBackground), before(&indent)
 {
 	out.precision(8);
 }
@@ -33,7 +34,10 @@ DataWriter::DataWriter(const string &path)
 
 DataWriter::~DataWriter()
 {
-	Files::Write(path, out.str());
+	if(inBackground)
+		WriteQueue::Add(path, out.str());
+	else
+		Files::Write(path, out.str());
 }
 
 
@@ -25,9 +25,12 @@ class DataNode;
 // using this class, you can have a function add data to the file without having
 // to tell that function what indentation level it is at. This class also
 // automatically adds quotation marks around strings if they contain whitespace.
+// Nothing is written to the file until this object is destroyed. If it is to be
+// written "in background," it is handed off to the WriteQueue at that point,
+// which replaces the file safely without making the caller wait for the disk.
 class DataWriter {
 public:
-	DataWriter(const std::string &path);
+	DataWriter(const std::string &path, bool inBackground = false);
 	~DataWriter();
 	
   template <class A, class ...B>
@@ -49,6 +52,7 @@ public:
 	
 private:
 	std::string path;
+	bool inBackground;
 	std::string indent;
 	static const std::string space;
 	const std::string *before;
@@ -19,10 +19,19 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "SpriteSet.h"
 #include "SpriteShader.h"
 
+#include <algorithm>
 #include <cmath>
 
 using namespace std;
 
+namespace {
+	bool Overlaps(const Point &topLeft, const Point &bottomRight, const Point &otherTopLeft, const Point &otherBottomRight)
+	{
+		return !(bottomRight.X() < otherTopLeft.X() || otherBottomRight.X() < topLeft.X()
+			|| bottomRight.Y() < otherTopLeft.Y() || otherBottomRight.Y() < topLeft.Y());
+	}
+}
+
 
 
 // Default constructor.
@@ -36,8 +45,25 @@ DrawList::DrawList()
 // Clear the list.
 void DrawList::Clear(int step)
 {
-	items.clear();
+	// The items' and batches' storage is kept, to be reused by the next frame.
+	for(vector<Item> &layerItems : items)
+		layerItems.clear();
+	batchCount = 0;
+	layer = BACKGROUND;
+	submittedChanges = 0;
+	lastTex0 = 0;
+	lastTex1 = 0;
+	
 	this->step = step;
+	showBlur = Preferences::Has("Render motion blur");
+}
+
+
+
+// Select which layer subsequent items are added to.
+void DrawList::SetLayer(Layer layer)
+{
+	this->layer = layer;
 }
 
 
@@ -48,20 +74,8 @@ bool DrawList::Add(const Animation &animation, Point pos, Point unit, Point blur
 	if(animation.IsEmpty() || !unit)
 		return false;
 	
-	// Cull sprites that are completely off screen, to reduce the number of draw
-	// calls that we issue (which may be the bottleneck on some systems).
-	Point size(
-		.5 * (fabs(unit.X() * animation.Height()) + fabs(unit.Y() * animation.Width()) + fabs(blur.X())),
-		.5 * (fabs(unit.X() * animation.Width()) + fabs(unit.Y() * animation.Height()) + fabs(blur.Y())));
-	Point topLeft = pos - size;
-	Point bottomRight = pos + size;
-	if(bottomRight.X() < Screen::Left() || bottomRight.Y() < Screen::Top())
-		return false;
-	if(topLeft.X() > Screen::Right() || topLeft.Y() > Screen::Bottom())
-		return false;
-		
-	items.emplace_back(animation, pos, unit, blur, clip, step);
-	return true;
+	return Add(animation.Get(step), animation.GetSwizzle(),
+		animation.Width(), animation.Height(), pos, unit, blur, clip);
 }
 
 
@@ -73,14 +87,32 @@ bool DrawList::Add(const Sprite *sprite, Point pos, Point unit, Point blur, doub
 		return false;
 	
 	Animation animation(sprite, 1.f);
-	animation.SetSwizzle(swizzle);
-	if(!Add(animation, pos, unit, blur))
+	if(animation.IsEmpty() || !unit)
 		return false;
 	
+	// A cloaked sprite fades into the "cloaked" texture.
+	Animation::Frame frame = animation.Get(step);
 	if(cloak > 0.)
-		items.back().Cloak(cloak);
-	
-	return true;
+	{
+		frame.second = SpriteSet::Get("ship/cloaked")->GetRegion();
+		frame.fade = cloak;
+	}
+	return Add(frame, swizzle, animation.Width(), animation.Height(), pos, unit, blur, 1.);
+}
+
+
+
+// Sort the items in each layer into batches.
+void DrawList::Finish()
+{
+	batchCount = 0;
+	for(const vector<Item> &layerItems : items)
+	{
+		// Items can only be batched with others in the same layer.
+		size_t firstBatch = batchCount;
+		for(const Item &item : layerItems)
+			Push(item, firstBatch);
+	}
 }
 
 
@@ -88,30 +120,75 @@ bool DrawList::Add(const Sprite *sprite, Point pos, Point unit, Point blur, doub
 // Draw all the items in this list.
 void DrawList::Draw() const
 {
-	bool showBlur = Preferences::Has("Render motion blur");
 	SpriteShader::Bind();
+	
+	for(size_t i = 0; i < batchCount; ++i)
+	{
+		const Batch &batch = batches[i];
+		SpriteShader::Add(batch.tex0, batch.tex1, batch.instances.data(), batch.instances.size());
+	}
+	
+	SpriteShader::Unbind();
+}
 
-	for(const Item &item : items)
-		SpriteShader::Add(item.Texture0(), item.Texture1(),
-			item.Position(), item.Transform(),
-			item.Swizzle(), item.Clip(), item.Fade(), showBlur ? item.Blur() : nullptr);
 
-	SpriteShader::Unbind();
+
+// Get the number of texture changes in the order the items were added.
+int DrawList::SubmittedStateChanges() const
+{
+	return submittedChanges;
 }
 
 
 
-DrawList::Item::Item(const Animation &animation, Point pos, Point unit, Point blur, float clip, int step)
-	: position{static_cast<float>(pos.X()), static_cast<float>(pos.Y())},
-	clip(clip), flags(animation.GetSwizzle())
+// Get the number of texture changes needed to draw the sorted batches.
+int DrawList::StateChanges() const
 {
-	Animation::Frame frame = animation.Get(step);
-	tex0 = frame.first;
-	tex1 = frame.second;
-	flags |= static_cast<uint32_t>(frame.fade * 256.f) << 8;
+	return batchCount;
+}
+
+
+
+// Add an item with the given textures and parameters.
+bool DrawList::Add(const Animation::Frame &frame, int swizzle, double width, double height, Point pos, Point unit, Point blur, double clip)
+{
+	// Cull sprites that are completely off screen, to reduce the number of draw
+	// calls that we issue (which may be the bottleneck on some systems).
+	Point size(
+		.5 * (fabs(unit.X() * height) + fabs(unit.Y() * width) + fabs(blur.X())),
+		.5 * (fabs(unit.X() * width) + fabs(unit.Y() * height) + fabs(blur.Y())));
+	Point topLeft = pos - size;
+	Point bottomRight = pos + size;
+	if(bottomRight.X() < Screen::Left() || bottomRight.Y() < Screen::Top())
+		return false;
+	if(topLeft.X() > Screen::Right() || topLeft.Y() > Screen::Bottom())
+		return false;
+	// If the sprite is not loaded yet, getting its frame has already asked for
+	// it to be loaded. Until then, there is nothing to draw.
+	if(!frame.first.texture)
+		return false;
+	
+	// Only use the second texture if the item is actually fading into it.
+	uint32_t tex1 = (frame.fade ? frame.second.texture : 0);
+	if(frame.first.texture != lastTex0 || tex1 != lastTex1)
+		++submittedChanges;
+	lastTex0 = frame.first.texture;
+	lastTex1 = tex1;
+	
+	items[layer].emplace_back();
+	Item &entry = items[layer].back();
+	entry.tex0 = frame.first.texture;
+	entry.tex1 = tex1;
+	entry.topLeft = topLeft;
+	entry.bottomRight = bottomRight;
+	
+	SpriteShader::Instance &item = entry.instance;
+	item.clip = clip;
+	item.fade = tex1 ? frame.fade : 0.f;
+	item.swizzle = swizzle;
+	copy(frame.first.rect, frame.first.rect + 4, item.rect0);
+	copy(frame.second.rect, frame.second.rect + 4, item.rect1);
 	
-	double width = animation.Width();
-	double height = animation.Height();
 	Point uw = unit * width;
 	Point uh = unit * height;
 	
@@ -120,95 +197,71 @@ DrawList::Item::Item(const Animation &animation, Point pos, Point unit, Point bl
 		// "clip" is the fraction of its height that we're clipping the sprite
 		// to. We still want it to start at the same spot, though.
 		pos -= uh * ((1. - clip) * .5);
-		position[0] = static_cast<float>(pos.X());
-		position[1] = static_cast<float>(pos.Y());
 		uh *= clip;
 	}
+	item.position[0] = static_cast<float>(pos.X());
+	item.position[1] = static_cast<float>(pos.Y());
 	
 	// (0, -1) means a zero-degree rotation (since negative Y is up).
-	transform[0] = -uw.Y();
-	transform[1] = uw.X();
-	transform[2] = -uh.X();
-	transform[3] = -uh.Y();
+	item.transform[0] = -uw.Y();
+	item.transform[1] = uw.X();
+	item.transform[2] = -uh.X();
+	item.transform[3] = -uh.Y();
 	
 	// Calculate the blur vector, in texture coordinates. This should be done by
 	// projecting the blur vector onto the unit vector and then scaling it based
 	// on the sprite size. But, the unit vector first has to be normalized (i.e.
 	// divided by the unit vector length), and the sprite size also has to be
 	// multiplied by the unit vector size, so:
-	double zoomCorrection = 4. * unit.LengthSquared();
-	this->blur[0] = unit.Cross(blur) / (width * zoomCorrection);
-	this->blur[1] = -unit.Dot(blur) / (height * zoomCorrection);
-}
-
-
-
-// Get the texture of this sprite.
-uint32_t DrawList::Item::Texture0() const
-{
-	return tex0;
-}
-
-
-
-uint32_t DrawList::Item::Texture1() const
-{
-	return tex1;
-}
-
-
-
-// These two items can be uploaded directly to the shader:
-// Get the (x, y) position of the center of the sprite.
-const float *DrawList::Item::Position() const
-{
-	return position;
-}
-
-
-
-// Get the [a, b; c, d] size and rotation matrix.
-const float *DrawList::Item::Transform() const
-{
-	return transform;
-}
-
-
-
-// Get the blur vector, in texture space.
-const float *DrawList::Item::Blur() const
-{
-	return blur;
-}
-
-
-		
-// Get the color swizzle.
-uint32_t DrawList::Item::Swizzle() const
-{
-	return (flags & 7);
-}
-
-
-
-		
-float DrawList::Item::Clip() const
-{
-	return clip;
-}
-
-
-
-float DrawList::Item::Fade() const
-{
-	return (flags >> 8) / 256.f;
+	item.blur[0] = 0.f;
+	item.blur[1] = 0.f;
+	if(showBlur)
+	{
+		double zoomCorrection = 4. * unit.LengthSquared();
+		item.blur[0] = unit.Cross(blur) / (width * zoomCorrection);
+		item.blur[1] = -unit.Dot(blur) / (height * zoomCorrection);
+	}
+	return true;
 }
 
 
 
-void DrawList::Item::Cloak(double cloak)
+// Add an item to the batch for its textures, creating a new batch if no
+// existing one at or after firstBatch can be used.
+void DrawList::Push(const Item &item, size_t firstBatch)
 {
-	tex1 = SpriteSet::Get("ship/cloaked")->Texture();
-	flags &= 0xFF;
-	flags |= static_cast<uint32_t>(cloak * 256.f) << 8;
+	// Look back through the batches in this layer for one with the same
+	// textures. Stop looking if the item would end up drawn underneath
+	// something that it overlaps and that was added before it.
+	Batch *batch = nullptr;
+	for(size_t i = batchCount; i-- > firstBatch; )
+	{
+		Batch &it = batches[i];
+		if(it.tex0 == item.tex0 && it.tex1 == item.tex1)
+		{
+			batch = &it;
+			break;
+		}
+		if(Overlaps(item.topLeft, item.bottomRight, it.topLeft, it.bottomRight))
+			break;
+	}
+	
+	if(batch)
+	{
+		batch->topLeft = Point(min(batch->topLeft.X(), item.topLeft.X()), min(batch->topLeft.Y(), item.topLeft.Y()));
+		batch->bottomRight = Point(max(batch->bottomRight.X(), item.bottomRight.X()), max(batch->bottomRight.Y(), item.bottomRight.Y()));
+	}
+	else
+	{
+		if(batchCount == batches.size())
+			batches.emplace_back();
+		batch = &batches[batchCount++];
+		batch->tex0 = item.tex0;
+		batch->tex1 = item.tex1;
+		batch->topLeft = item.topLeft;
+		batch->bottomRight = item.bottomRight;
+		batch->instances.clear();
+	}
+	
+	batch->instances.push_back(item.instance);
 }
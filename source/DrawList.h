@@ -13,12 +13,14 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef DRAW_LIST_H_
 #define DRAW_LIST_H_
 
+#include "Animation.h"
 #include "Point.h"
+#include "SpriteShader.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
-class Animation;
 class Sprite;
 
 
@@ -28,13 +30,35 @@ class Sprite;
 // thread from the graphics thread. However, the SpriteShader class is also
 // available for drawing individual sprites in contexts where putting them into
 // a DrawList first does not make sense.
+// Items are added to one of several layers, which are drawn in order. Once
+// everything has been added, Finish() sorts each layer into batches that share
+// the same textures, so that each batch can be drawn with a single call. An
+// item may join an earlier batch only if it does not overlap anything that is
+// drawn after that batch, so within a layer the result looks the same as
+// drawing every item in the order it was added.
 class DrawList {
+public:
+	enum Layer {
+		BACKGROUND,
+		PLANETS,
+		ASTEROIDS,
+		SHIPS,
+		FLAGSHIP,
+		PROJECTILES,
+		EFFECTS,
+		LAYER_COUNT
+	};
+	
+	
 public:
 	// Default constructor.
 	DrawList();
 	
 	// Clear the list, also setting the global time step for animation.
 	void Clear(int step = 0);
+	// Select which layer subsequent items are added to. Clear() resets the
+	// layer to BACKGROUND.
+	void SetLayer(Layer layer);
 	
 	// Add an animation.
 	bool Add(const Animation &animation, Point pos, Point unit, Point blur = Point(), double clip = 1.);
@@ -42,51 +66,68 @@ public:
 	// Add a single sprite.
 	bool Add(const Sprite *sprite, Point pos, Point unit = Point(0., -1.), Point blur = Point(), double cloak = 0., int swizzle = 0);
 	
+	// Sort the items in each layer into batches. This should be done by the
+	// thread that built the list, so that drawing it is as cheap as possible.
+	void Finish();
 	// Draw all the items in this list. The shader object may be shared between
 	// multiple DrawLists, so pass it in here.
 	void Draw() const;
 	
+	// Get the number of texture changes that drawing the items in the order
+	// they were added would require, and the number that drawing the sorted
+	// batches requires.
+	int SubmittedStateChanges() const;
+	int StateChanges() const;
+	
+	
+private:
+	// Add an item with the given textures and parameters.
+	bool Add(const Animation::Frame &frame, int swizzle, double width, double height, Point pos, Point unit, Point blur, double clip);
+	
 	
 private:
 	class Item {
 	public:
-		Item() = default;
-		Item(const Animation &animation, Point pos, Point unit, Point blur, float clip, int step);
-		
-		// Get the texture of this sprite.
-		uint32_t Texture0() const;
-		uint32_t Texture1() const;
-		
-		// These two items can be uploaded directly to the shader:
-		// Get the (x, y) position of the center of the sprite.
-		const float *Position() const;
-		// Get the [a, b; c, d] size and rotation matrix.
-		const float *Transform() const;
-		// Get the blur vector, in texture space.
-		const float *Blur() const;
-		
-		// Get the color swizzle.
-		uint32_t Swizzle() const;
-		
-		float Clip() const;
-		float Fade() const;
-		
-		void Cloak(double cloak);
-		
-	private:
 		uint32_t tex0;
 		uint32_t tex1;
-		float position[2];
-		float transform[4];
-		float blur[2];
-		float clip;
-		uint32_t flags;
+		Point topLeft;
+		Point bottomRight;
+		SpriteShader::Instance instance;
+	};
+	
+	class Batch {
+	public:
+		uint32_t tex0;
+		uint32_t tex1;
+		// The bounding box of everything in this batch.
+		Point topLeft;
+		Point bottomRight;
+		std::vector<SpriteShader::Instance> instances;
 	};
 	
 	
 private:
-	int step;
-	std::vector<Item> items;
+	// Add an item to the batch for its textures, creating a new batch if no
+	// existing one at or after firstBatch can be used.
+	void Push(const Item &item, size_t firstBatch);
+	
+	
+private:
+	int step = 0;
+	bool showBlur = false;
+	Layer layer = BACKGROUND;
+	// The items in each layer, in the order they were added.
+	std::vector<Item> items[LAYER_COUNT];
+	// Batches are never removed from this vector, so that their instance
+	// vectors do not need to reallocate their storage every frame. Only the
+	// first batchCount of them are in use.
+	std::vector<Batch> batches;
+	size_t batchCount = 0;
+	
+	// Texture changes in submission order, and the last textures added.
+	int submittedChanges = 0;
+	uint32_t lastTex0 = 0;
+	uint32_t lastTex1 = 0;
 };
 
 
@@ -43,10 +43,38 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 using namespace std;
 
+namespace {
+	// Information slots for the parts of the HUD that are updated every step.
+	const int PLAYER_SPRITE = Information::Slot("player sprite");
+	const int LOCATION = Information::Slot("location");
+	const int DATE = Information::Slot("date");
+	const int FUEL = Information::Slot("fuel");
+	const int ENERGY = Information::Slot("energy");
+	const int HEAT = Information::Slot("heat");
+	const int SHIELDS = Information::Slot("shields");
+	const int HULL = Information::Slot("hull");
+	const int CREDITS = Information::Slot("credits");
+	const int NAVIGATION_MODE = Information::Slot("navigation mode");
+	const int DESTINATION = Information::Slot("destination");
+	const int TARGET_SPRITE = Information::Slot("target sprite");
+	const int TARGET_NAME = Information::Slot("target name");
+	const int TARGET_TYPE = Information::Slot("target type");
+	const int TARGET_GOVERNMENT = Information::Slot("target government");
+	const int TARGET_SHIELDS = Information::Slot("target shields");
+	const int TARGET_HULL = Information::Slot("target hull");
+}
+
 
 
 Engine::Engine(PlayerInfo &player)
-	: player(player)
+	: player(player),
+	statusInterface(GameData::Interfaces().GetHandle("status")),
+	targetsInterface(GameData::Interfaces().GetHandle("targets")),
+	ammoSelected(SpriteSet::GetHandle("ui/ammo selected")),
+	ammoUnselected(SpriteSet::GetHandle("ui/ammo unselected")),
+	bright(GameData::Colors().GetHandle("bright")),
+	dim(GameData::Colors().GetHandle("dim")),
+	medium(GameData::Colors().GetHandle("medium"))
 {
 	// Start the thread for doing calculations.
 	calcThread = thread(&Engine::ThreadEntryPoint, this);
@@ -65,6 +93,7 @@ Engine::Engine(PlayerInfo &player)
 		center = object->Position();
 	
 	// Now we know the player's current position. Draw the planets.
+	draw[calcTickTock].SetLayer(DrawList::PLANETS);
 	for(const StellarObject &object : player.GetSystem()->Objects())
 		if(!object.GetSprite().IsEmpty())
 		{
@@ -82,6 +111,7 @@ Engine::Engine(PlayerInfo &player)
 			draw[calcTickTock].Add(object.GetSprite(), position, unit);
 			radar[calcTickTock].Add(type, position, r, r - 1.);
 		}
+	draw[calcTickTock].Finish();
 	
 	// Add all neighboring systems to the radar.
 	const Ship *flagship = player.Flagship();
@@ -373,37 +403,37 @@ void Engine::Step(bool isActive)
 		Messages::Add("Your ship has overheated.");
 	
 	if(flagship && flagship->Hull())
-		info.SetSprite("player sprite", flagship->GetSprite().GetSprite());
+		info.SetSprite(PLAYER_SPRITE, flagship->GetSprite().GetSprite());
 	else
-		info.SetSprite("player sprite", nullptr);
+		info.SetSprite(PLAYER_SPRITE, nullptr);
 	if(currentSystem)
-		info.SetString("location", currentSystem->Name());
-	info.SetString("date", player.GetDate().ToString());
+		info.SetString(LOCATION, currentSystem->Name());
+	info.SetString(DATE, player.GetDate().ToString());
 	if(flagship)
 	{
-		info.SetBar("fuel", flagship->Fuel(),
+		info.SetBar(FUEL, flagship->Fuel(),
 			flagship->Attributes().Get("fuel capacity") * .01);
-		info.SetBar("energy", flagship->Energy());
-		info.SetBar("heat", flagship->Heat());
-		info.SetBar("shields", flagship->Shields());
-		info.SetBar("hull", flagship->Hull(), 20.);
+		info.SetBar(ENERGY, flagship->Energy());
+		info.SetBar(HEAT, flagship->Heat());
+		info.SetBar(SHIELDS, flagship->Shields());
+		info.SetBar(HULL, flagship->Hull(), 20.);
 	}
 	else
 	{
-		info.SetBar("fuel", 0.);
-		info.SetBar("energy", 0.);
-		info.SetBar("heat", 0.);
-		info.SetBar("shields", 0.);
-		info.SetBar("hull", 0.);
+		info.SetBar(FUEL, 0.);
+		info.SetBar(ENERGY, 0.);
+		info.SetBar(HEAT, 0.);
+		info.SetBar(SHIELDS, 0.);
+		info.SetBar(HULL, 0.);
 	}
-	info.SetString("credits",
+	info.SetString(CREDITS,
 		Format::Number(player.Accounts().Credits()) + " credits");
 	if(flagship && flagship->GetTargetPlanet() && !flagship->Commands().Has(Command::JUMP))
 	{
 		const StellarObject *object = flagship->GetTargetPlanet();
-		info.SetString("navigation mode", "Landing on:");
+		info.SetString(NAVIGATION_MODE, "Landing on:");
 		const string &name = object->Name();
-		info.SetString("destination", name);
+		info.SetString(DESTINATION, name);
 		
 		targets.push_back({
 			object->Position() - center,
@@ -413,16 +443,16 @@ void Engine::Step(bool isActive)
 	}
 	else if(flagship && flagship->GetTargetSystem())
 	{
-		info.SetString("navigation mode", "Hyperspace:");
+		info.SetString(NAVIGATION_MODE, "Hyperspace:");
 		if(player.HasVisited(flagship->GetTargetSystem()))
-			info.SetString("destination", flagship->GetTargetSystem()->Name());
+			info.SetString(DESTINATION, flagship->GetTargetSystem()->Name());
 		else
-			info.SetString("destination", "unexplored system");
+			info.SetString(DESTINATION, "unexplored system");
 	}
 	else
 	{
-		info.SetString("navigation mode", "Navigation:");
-		info.SetString("destination", "no destination");
+		info.SetString(NAVIGATION_MODE, "Navigation:");
+		info.SetString(DESTINATION, "no destination");
 	}
 	// Use the radar that was just populated. (The draw tick-tock has not
 	// yet been toggled, but it will be at the end of this function.)
@@ -432,24 +462,24 @@ void Engine::Step(bool isActive)
 		target = flagship->GetTargetShip();
 	if(!target)
 	{
-		info.SetSprite("target sprite", nullptr);
-		info.SetString("target name", "no target");
-		info.SetString("target type", "");
-		info.SetString("target government", "");
-		info.SetBar("target shields", 0.);
-		info.SetBar("target hull", 0.);
+		info.SetSprite(TARGET_SPRITE, nullptr);
+		info.SetString(TARGET_NAME, "no target");
+		info.SetString(TARGET_TYPE, "");
+		info.SetString(TARGET_GOVERNMENT, "");
+		info.SetBar(TARGET_SHIELDS, 0.);
+		info.SetBar(TARGET_HULL, 0.);
 	}
 	else
 	{
 		if(target->GetSystem() == player.GetSystem() && target->Cloaking() < 1.)
 			targetUnit = target->Facing().Unit();
-		info.SetSprite("target sprite", target->GetSprite().GetSprite(), targetUnit);
-		info.SetString("target name", target->Name());
-		info.SetString("target type", target->ModelName());
+		info.SetSprite(TARGET_SPRITE, target->GetSprite().GetSprite(), targetUnit);
+		info.SetString(TARGET_NAME, target->Name());
+		info.SetString(TARGET_TYPE, target->ModelName());
 		if(!target->GetGovernment())
-			info.SetString("target government", "No Government");
+			info.SetString(TARGET_GOVERNMENT, "No Government");
 		else
-			info.SetString("target government", target->GetGovernment()->GetName());
+			info.SetString(TARGET_GOVERNMENT, target->GetGovernment()->GetName());
 		
 		shared_ptr<const Ship> targetTarget = target->GetTargetShip();
 		bool hostile = targetTarget && targetTarget->GetGovernment()->IsPlayer();
@@ -460,8 +490,8 @@ void Engine::Step(bool isActive)
 		
 		if(target->GetSystem() == player.GetSystem() && target->IsTargetable())
 		{
-			info.SetBar("target shields", target->Shields());
-			info.SetBar("target hull", target->Hull(), 20.);
+			info.SetBar(TARGET_SHIELDS, target->Shields());
+			info.SetBar(TARGET_HULL, target->Hull(), 20.);
 		
 			// The target area will be a square, with sides equal to the average
 			// of the width and the height of the sprite.
@@ -483,8 +513,8 @@ void Engine::Step(bool isActive)
 		}
 		else
 		{
-			info.SetBar("target shields", 0.);
-			info.SetBar("target hull", 0.);
+			info.SetBar(TARGET_SHIELDS, 0.);
+			info.SetBar(TARGET_HULL, 0.);
 		}
 	}
 }
@@ -522,6 +552,7 @@ void Engine::Draw() const
 	
 	draw[drawTickTock].Draw();
 	
+	RingShader::Bind();
 	for(const auto &it : statuses)
 	{
 		if(it.hull <= 0.)
@@ -533,9 +564,10 @@ void Engine::Draw() const
 			Color(.45, .5, 0., .25),
 			Color(.5, .3, 0., .25)
 		};
-		RingShader::Draw(it.position, it.radius + 3., 1.5, it.shields, color[it.isEnemy]);
-		RingShader::Draw(it.position, it.radius, 1.5, it.hull, color[2 + it.isEnemy], 20.);
+		RingShader::Add(it.position, it.radius + 3., 1.5, it.shields, color[it.isEnemy]);
+		RingShader::Add(it.position, it.radius, 1.5, it.hull, color[2 + it.isEnemy], 20.);
 	}
+	RingShader::Unbind();
 	
 	if(flash)
 		FillShader::Fill(Point(), Point(Screen::Width(), Screen::Height()), Color(flash, flash));
@@ -563,6 +595,7 @@ void Engine::Draw() const
 	}
 	
 	// Draw crosshairs around anything that is targeted.
+	PointerShader::Bind();
 	for(const Target &target : targets)
 	{
 		Angle a = target.angle;
@@ -570,15 +603,16 @@ void Engine::Draw() const
 		
 		for(int i = 0; i < 4; ++i)
 		{
-			PointerShader::Draw(target.center, a.Unit(), 12., 14., -target.radius,
+			PointerShader::Add(target.center, a.Unit(), 12., 14., -target.radius,
 				Radar::GetColor(target.type));
 			a += da;
 		}
 	}
+	PointerShader::Unbind();
 	
 	const Interface *interfaces[2] = {
-		GameData::Interfaces().Get("status"),
-		GameData::Interfaces().Get("targets")
+		statusInterface.Get(),
+		targetsInterface.Get()
 	};
 	for(const Interface *interface : interfaces)
 	{
@@ -603,10 +637,10 @@ void Engine::Draw() const
 	
 	// Draw ammo status.
 	Point pos(Screen::Right() - 80, Screen::Bottom());
-	const Sprite *selectedSprite = SpriteSet::Get("ui/ammo selected");
-	const Sprite *unselectedSprite = SpriteSet::Get("ui/ammo unselected");
-	Color selectedColor = *GameData::Colors().Get("bright");
-	Color unselectedColor = *GameData::Colors().Get("dim");
+	const Sprite *selectedSprite = ammoSelected.Get();
+	const Sprite *unselectedSprite = ammoUnselected.Get();
+	const Color &selectedColor = *bright;
+	const Color &unselectedColor = *dim;
 	for(const pair<const Outfit *, int> &it : ammo)
 	{
 		pos.Y() -= 30.;
@@ -633,9 +667,16 @@ void Engine::Draw() const
 	if(Preferences::Has("Show CPU / GPU load"))
 	{
 		string loadString = to_string(static_cast<int>(load * 100. + .5)) + "% CPU";
-		Color color = *GameData::Colors().Get("medium");
+		// In debug mode, also show how many texture changes sorting the draw
+		// list saved.
+		if(GameData::DebugMode())
+		{
+			const DrawList &list = draw[drawTickTock];
+			loadString = to_string(list.StateChanges()) + " / "
+				+ to_string(list.SubmittedStateChanges()) + " binds, " + loadString;
+		}
 		font.Draw(loadString,
-			Point(-10 - font.Width(loadString), Screen::Height() * -.5 + 5.), color);
+			Point(-10 - font.Width(loadString), Screen::Height() * -.5 + 5.), *medium);
 	}
 }
 
@@ -848,6 +889,7 @@ void Engine::CalculateStep()
 	else
 		doClick = false;
 	
+	draw[calcTickTock].SetLayer(DrawList::PLANETS);
 	for(const StellarObject &object : player.GetSystem()->Objects())
 		if(!object.GetSprite().IsEmpty())
 		{
@@ -901,6 +943,7 @@ void Engine::CalculateStep()
 	// of them. This could be done later, as long as it is done before the
 	// collision detection.
 	asteroids.Step();
+	draw[calcTickTock].SetLayer(DrawList::ASTEROIDS);
 	asteroids.Draw(draw[calcTickTock], newCenter, newCenterVelocity);
 	
 	// Move existing projectiles. Do this before ships fire, which will create
@@ -923,6 +966,7 @@ void Engine::CalculateStep()
 	projectiles.splice(projectiles.end(), newProjectiles);
 	
 	// Move the flotsam, which should be drawn underneath the ships.
+	draw[calcTickTock].SetLayer(DrawList::SHIPS);
 	for(auto it = flotsam.begin(); it != flotsam.end(); )
 	{
 		if(!it->Move(effects))
@@ -1075,6 +1119,7 @@ void Engine::CalculateStep()
 		}
 	if(flagship && showFlagship)
 	{
+		draw[calcTickTock].SetLayer(DrawList::FLAGSHIP);
 		AddSprites(*flagship, Point(), Point());
 		if(flagship->IsThrusting())
 		{
@@ -1100,6 +1145,8 @@ void Engine::CalculateStep()
 	// Collision detection:
 	if(grudgeTime)
 		--grudgeTime;
+	
+	draw[calcTickTock].SetLayer(DrawList::PROJECTILES);
 	for(Projectile &projectile : projectiles)
 	{
 		// The asteroids can collide with projectiles, the same as any other
@@ -1204,6 +1251,7 @@ void Engine::CalculateStep()
 	// Finally, draw all the effects, and then move them (because their motion
 	// is not dependent on anything else, and this way we do all the work on
 	// them in a single place.
+	draw[calcTickTock].SetLayer(DrawList::EFFECTS);
 	for(auto it = effects.begin(); it != effects.end(); )
 	{
 		draw[calcTickTock].Add(
@@ -1295,6 +1343,10 @@ void Engine::CalculateStep()
 	// A mouse click should only be active for a single step.
 	doClick = false;
 	
+	// Sort the draw list into batches now, while the draw thread is still busy
+	// with the previous frame.
+	draw[calcTickTock].Finish();
+	
 	// Keep track of how much of the CPU time we are using.
 	loadSum += loadTimer.Time();
 	if(++loadCount == 60)
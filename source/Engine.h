@@ -18,6 +18,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "DrawList.h"
 #include "EscortDisplay.h"
 #include "Flotsam.h"
+#include "Handle.h"
 #include "Information.h"
 #include "PlanetLabel.h"
 #include "Point.h"
@@ -33,9 +34,12 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include <thread>
 #include <vector>
 
+class Color;
 class Government;
+class Interface;
 class Outfit;
 class PlayerInfo;
+class Sprite;
 
 
 
@@ -107,6 +111,15 @@ private:
 private:
 	PlayerInfo &player;
 	
+	// Interface elements that are drawn every frame.
+	Handle<Interface> statusInterface;
+	Handle<Interface> targetsInterface;
+	Handle<Sprite> ammoSelected;
+	Handle<Sprite> ammoUnselected;
+	Handle<Color> bright;
+	Handle<Color> dim;
+	Handle<Color> medium;
+	
 	AI ai;
 	
 	std::thread calcThread;
@@ -0,0 +1,124 @@
+/* FileWatcher.cpp
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "FileWatcher.h"
+
+#include "Files.h"
+
+#if defined __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+#include <set>
+#include <utility>
+
+using namespace std;
+
+namespace {
+#if defined __linux__
+	// A directory being created or moved in must be watched too. Files are
+	// only reported once they are closed, so that a file that is written in
+	// several pieces is not reloaded before it is complete.
+	const uint32_t EVENTS = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+#endif
+}
+
+
+
+// Watch the given directories, and every directory inside them.
+FileWatcher::FileWatcher(const vector<string> &directories)
+{
+#if defined __linux__
+	fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(fd < 0)
+	{
+		Files::LogError("Warning: unable to watch for changes to the game's files.");
+		return;
+	}
+	
+	for(const string &root : directories)
+	{
+		vector<pair<string, int64_t>> files;
+		vector<pair<string, time_t>> list;
+		Files::RecursiveList(root, &files, &list);
+		for(const pair<string, time_t> &it : list)
+			if(it.second)
+				Watch(it.first);
+	}
+#endif
+}
+
+
+
+FileWatcher::~FileWatcher()
+{
+#if defined __linux__
+	if(fd >= 0)
+		close(fd);
+#endif
+}
+
+
+
+// Get every file that has been written to or moved into place since the last
+// time this was called. This never waits for a change to happen.
+vector<string> FileWatcher::Changes()
+{
+	// An editor may write the same file more than once when saving it.
+	set<string> changed;
+#if defined __linux__
+	if(fd < 0)
+		return vector<string>();
+	
+	alignas(inotify_event) char buffer[4096];
+	while(true)
+	{
+		ssize_t length = read(fd, buffer, sizeof(buffer));
+		if(length <= 0)
+			break;
+		
+		for(const char *it = buffer; it < buffer + length; )
+		{
+			const inotify_event &event = *reinterpret_cast<const inotify_event *>(it);
+			it += sizeof(inotify_event) + event.len;
+			
+			auto watch = watches.find(event.wd);
+			// Skip dotfiles, which are often an editor's temporary files.
+			if(watch == watches.end() || !event.len || event.name[0] == '.')
+				continue;
+			
+			string path = watch->second + event.name;
+			if(event.mask & IN_ISDIR)
+			{
+				if(event.mask & (IN_CREATE | IN_MOVED_TO))
+					Watch(path + '/');
+			}
+			else if(event.mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+				changed.insert(path);
+		}
+	}
+#endif
+	return vector<string>(changed.begin(), changed.end());
+}
+
+
+
+void FileWatcher::Watch(const string &directory)
+{
+#if defined __linux__
+	int wd = inotify_add_watch(fd, directory.c_str(), EVENTS);
+	if(wd >= 0)
+		watches[wd] = directory;
+#endif
+}
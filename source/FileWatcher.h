@@ -0,0 +1,51 @@
+/* FileWatcher.h
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef FILE_WATCHER_H_
+#define FILE_WATCHER_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+
+// Class which watches a set of directories for files being changed, so that
+// they can be reloaded while the game is running. This is only implemented on
+// Linux (using inotify); on any other system, no changes are ever reported.
+class FileWatcher {
+public:
+	// Watch the given directories, and every directory inside them.
+	explicit FileWatcher(const std::vector<std::string> &directories);
+	FileWatcher(const FileWatcher &) = delete;
+	~FileWatcher();
+	
+	FileWatcher &operator=(const FileWatcher &) = delete;
+	
+	// Get every file that has been written to or moved into place since the
+	// last time this was called. This never waits for a change to happen.
+	std::vector<std::string> Changes();
+	
+	
+private:
+	void Watch(const std::string &directory);
+	
+	
+private:
+	int fd = -1;
+	// The directory that each watch descriptor refers to.
+	std::map<int, std::string> watches;
+};
+
+
+
+#endif
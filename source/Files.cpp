@@ -18,6 +18,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #if defined _WIN32
 #include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
 #endif
 
 #include <sys/stat.h>
@@ -345,9 +348,23 @@ vector<string> Files::RecursiveList(const string &directory)
 
 
 void Files::RecursiveList(string directory, vector<string> *list)
+{
+	vector<pair<string, int64_t>> files;
+	RecursiveList(directory, &files, nullptr);
+	for(pair<string, int64_t> &file : files)
+		list->push_back(move(file.first));
+}
+
+
+
+// Like RecursiveList(), but also record the size of each file, and the
+// modification time of each directory that was listed.
+void Files::RecursiveList(string directory, vector<pair<string, int64_t>> *files, vector<pair<string, time_t>> *directories)
 {
 	if(directory.empty() || directory.back() != '/')
 		directory += '/';
+	if(directories)
+		directories->emplace_back(directory, Timestamp(directory));
 	
 #if defined _WIN32
 	WIN32_FIND_DATAW ffd;
@@ -360,9 +377,10 @@ void Files::RecursiveList(string directory, vector<string> *list)
 			continue;
 		
 		if(!(ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
-			list->push_back(directory + ToUTF8(ffd.cFileName));
+			files->emplace_back(directory + ToUTF8(ffd.cFileName),
+				(static_cast<int64_t>(ffd.nFileSizeHigh) << 32) | ffd.nFileSizeLow);
 		else
-			RecursiveList(directory + ToUTF8(ffd.cFileName) + '/', list);
+			RecursiveList(directory + ToUTF8(ffd.cFileName) + '/', files, directories);
 	} while(FindNextFileW(hFind, &ffd));
 	
 	FindClose(hFind);
@@ -389,9 +407,9 @@ void Files::RecursiveList(string directory, vector<string> *list)
 		bool isDirectory = S_ISDIR(buf.st_mode);
 		
 		if(isRegularFile)
-			list->push_back(name);
+			files->emplace_back(name, buf.st_size);
 		else if(isDirectory)
-			RecursiveList(name + '/', list);
+			RecursiveList(name + '/', files, directories);
 	}
 	
 	closedir(dir);
@@ -413,6 +431,60 @@ bool Files::Exists(const string &filePath)
 
 
 
+// Get the last modification time of the given file, or 0 if it does not exist.
+time_t Files::Timestamp(const string &filePath)
+{
+#if defined _WIN32
+	struct _stat buf;
+	if(_wstat(ToUTF16(filePath).c_str(), &buf))
+		return 0;
+#else
+	struct stat buf;
+	if(stat(filePath.c_str(), &buf))
+		return 0;
+#endif
+	return buf.st_mtime;
+}
+
+
+
+// Get the size of the given file in bytes, or 0 if it does not exist.
+int64_t Files::Size(const string &filePath)
+{
+#if defined _WIN32
+	struct _stat buf;
+	if(_wstat(ToUTF16(filePath).c_str(), &buf))
+		return 0;
+#else
+	struct stat buf;
+	if(stat(filePath.c_str(), &buf))
+		return 0;
+#endif
+	return buf.st_size;
+}
+
+
+
+// Create the given directory, and any missing directories above it.
+void Files::CreateFolder(const string &path)
+{
+	if(path.empty() || Exists(path))
+		return;
+	
+	// Make sure the parent directory exists first.
+	size_t end = path.rfind('/', path.length() - 2);
+	if(end != string::npos && end)
+		CreateFolder(path.substr(0, end));
+	
+#if defined _WIN32
+	CreateDirectoryW(ToUTF16(path).c_str(), nullptr);
+#else
+	mkdir(path.c_str(), 0755);
+#endif
+}
+
+
+
 void Files::Copy(const string &from, const string &to)
 {
 #if defined _WIN32
@@ -508,6 +580,53 @@ void Files::Write(FILE *file, const string &data)
 
 
 
+// Write the given data to a temporary file, make sure it has reached the disk,
+// and then move it into place.
+bool Files::Replace(const string &path, const string &data)
+{
+	// The temporary file is a dotfile, so that if it is left behind it does
+	// not show up when listing the directory it is in.
+	size_t slash = path.rfind('/') + 1;
+	string temp = path.substr(0, slash) + '.' + path.substr(slash) + '~';
+	
+	FILE *file = Open(temp, true);
+	if(!file)
+		return false;
+	
+	bool success = (fwrite(data.data(), 1, data.size(), file) == data.size() && !fflush(file));
+#if defined _WIN32
+	success &= !_commit(_fileno(file));
+#else
+	success &= !fsync(fileno(file));
+#endif
+	success &= !fclose(file);
+	
+#if defined _WIN32
+	success = success && MoveFileExW(ToUTF16(temp).c_str(), ToUTF16(path).c_str(),
+		MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+	success = success && !rename(temp.c_str(), path.c_str());
+	// The new name is not safely on the disk until the directory is, too.
+	if(success)
+	{
+		int directory = open(slash ? path.substr(0, slash).c_str() : ".", O_RDONLY);
+		if(directory >= 0)
+		{
+			fsync(directory);
+			close(directory);
+		}
+	}
+#endif
+	if(!success)
+	{
+		Delete(temp);
+		LogError("Error: unable to write \"" + path + "\".");
+	}
+	return success;
+}
+
+
+
 void Files::LogError(const string &message)
 {
 	lock_guard<mutex> lock(errorMutex);
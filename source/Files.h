@@ -13,8 +13,11 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef FILES_H_
 #define FILES_H_
 
+#include <cstdint>
 #include <cstdio>
+#include <ctime>
 #include <string>
+#include <utility>
 #include <vector>
 
 
@@ -45,8 +48,16 @@ public:
 	// that it contains, recursively.
 	static std::vector<std::string> RecursiveList(const std::string &directory);
 	static void RecursiveList(std::string directory, std::vector<std::string> *list);
+	// Like RecursiveList(), but also record the size of each file, and the
+	// modification time of each directory that was listed (if directories is
+	// not null), including the given one.
+	static void RecursiveList(std::string directory, std::vector<std::pair<std::string, int64_t>> *files,
+		std::vector<std::pair<std::string, time_t>> *directories);
 	
 	static bool Exists(const std::string &filePath);
+	static time_t Timestamp(const std::string &filePath);
+	static int64_t Size(const std::string &filePath);
+	static void CreateFolder(const std::string &path);
 	static void Copy(const std::string &from, const std::string &to);
 	static void Delete(const std::string &filePath);
 	
@@ -59,6 +70,11 @@ public:
 	static std::string Read(FILE *file);
 	static void Write(const std::string &path, const std::string &data);
 	static void Write(FILE *file, const std::string &data);
+	// Write the given data to a temporary file, make sure it has reached the
+	// disk, and then move it into place. The file at the given path is never
+	// left half written, even if the game or the computer crashes while this
+	// is being done. Returns false if the file could not be written.
+	static bool Replace(const std::string &path, const std::string &data);
 	
 	static void LogError(const std::string &message);
 };
@@ -17,19 +17,36 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Screen.h"
 #include "Shader.h"
 
+#include <initializer_list>
 #include <stdexcept>
+#include <vector>
 
 using namespace std;
 
 namespace {
 	Shader shader;
 	GLint scaleI;
-	GLint centerI;
-	GLint sizeI;
-	GLint colorI;
 	
 	GLuint vao;
 	GLuint vbo;
+	
+	// Each rectangle is drawn as two triangles. Every vertex carries a copy of
+	// the rectangle's parameters, so any number of them can be drawn at once.
+	const int STRIDE = 10;
+	const float CORNERS[6][2] = {
+		{-.5f, -.5f}, {.5f, -.5f}, {-.5f, .5f},
+		{.5f, -.5f}, {.5f, .5f}, {-.5f, .5f}
+	};
+	// Rectangles added since the last call to Bind().
+	vector<GLfloat> vertices;
+	
+	void EnableAttrib(const char *name, int size, int offset)
+	{
+		GLuint attrib = shader.Attrib(name);
+		glEnableVertexAttribArray(attrib);
+		glVertexAttribPointer(attrib, size, GL_FLOAT, GL_FALSE,
+			STRIDE * sizeof(GLfloat), reinterpret_cast<const GLvoid *>(offset * sizeof(GLfloat)));
+	}
 }
 
 
@@ -38,29 +55,29 @@ void FillShader::Init()
 {
 	static const char *vertexCode =
 		"uniform vec2 scale;\n"
-		"uniform vec2 center;\n"
-		"uniform vec2 size;\n"
 		
 		"in vec2 vert;\n"
+		"in vec2 center;\n"
+		"in vec2 size;\n"
+		"in vec4 color;\n"
+		
+		"out vec4 fillColor;\n"
 		
 		"void main() {\n"
+		"  fillColor = color;\n"
 		"  gl_Position = vec4((center + vert * size) * scale, 0, 1);\n"
 		"}\n";
 
 	static const char *fragmentCode =
-		"uniform vec4 color = vec4(1, 1, 1, 1);\n"
-		
+		"in vec4 fillColor;\n"
 		"out vec4 finalColor;\n"
 		
 		"void main() {\n"
-		"  finalColor = color;\n"
+		"  finalColor = fillColor;\n"
 		"}\n";
 	
 	shader = Shader(vertexCode, fragmentCode);
 	scaleI = shader.Uniform("scale");
-	centerI = shader.Uniform("center");
-	sizeI = shader.Uniform("size");
-	colorI = shader.Uniform("color");
 	
 	// Generate the vertex data for drawing sprites.
 	glGenVertexArrays(1, &vao);
@@ -69,17 +86,10 @@ void FillShader::Init()
 	glGenBuffers(1, &vbo);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	
-	GLfloat vertexData[] = {
-		-.5f, -.5f,
-		 .5f, -.5f,
-		-.5f,  .5f,
-		 .5f,  .5f
-	};
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertexData), vertexData, GL_STATIC_DRAW);
-	
-	glEnableVertexAttribArray(shader.Attrib("vert"));
-	glVertexAttribPointer(shader.Attrib("vert"), 2, GL_FLOAT, GL_FALSE,
-		2 * sizeof(GLfloat), NULL);
+	EnableAttrib("vert", 2, 0);
+	EnableAttrib("center", 2, 2);
+	EnableAttrib("size", 2, 4);
+	EnableAttrib("color", 4, 6);
 	
 	// unbind the VBO and VAO
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -90,24 +100,58 @@ void FillShader::Init()
 
 void FillShader::Fill(const Point &center, const Point &size, const Color &color)
 {
-	if(!shader.Object())
-		throw runtime_error("FillShader: Draw() called before Init().");
+	Bind();
 	
-	glUseProgram(shader.Object());
-	glBindVertexArray(vao);
-	
-	GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
-	glUniform2fv(scaleI, 1, scale);
+	Add(center, size, color);
 	
-	GLfloat centerV[2] = {static_cast<float>(center.X()), static_cast<float>(center.Y())};
-	glUniform2fv(centerI, 1, centerV);
-	
-	GLfloat sizeV[2] = {static_cast<float>(size.X()), static_cast<float>(size.Y())};
-	glUniform2fv(sizeI, 1, sizeV);
+	Unbind();
+}
+
+
+
+void FillShader::Bind()
+{
+	if(!shader.Object())
+		throw runtime_error("FillShader: Bind() called before Init().");
 	
-	glUniform4fv(colorI, 1, color.Get());
+	vertices.clear();
+}
+
+
+
+void FillShader::Add(const Point &center, const Point &size, const Color &color)
+{
+	float x = center.X();
+	float y = center.Y();
+	float width = size.X();
+	float height = size.Y();
+	const float *c = color.Get();
 	
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	for(const float *corner : CORNERS)
+		vertices.insert(vertices.end(), {corner[0], corner[1], x, y,
+			width, height, c[0], c[1], c[2], c[3]});
+}
+
+
+
+// Draw all the rectangles that were added since Bind() with a single call.
+void FillShader::Unbind()
+{
+	if(!vertices.empty())
+	{
+		glUseProgram(shader.Object());
+		glBindVertexArray(vao);
+		
+		GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
+		glUniform2fv(scaleI, 1, scale);
+		
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		
+		glDrawArrays(GL_TRIANGLES, 0, vertices.size() / STRIDE);
+		vertices.clear();
+	}
 	
 	glBindVertexArray(0);
 	glUseProgram(0);
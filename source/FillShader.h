@@ -20,12 +20,17 @@ class Color;
 
 // Class holding a function to fill a rectangular region of the screen with a
 // given color. This can be used with translucent colors to darken or lighten a
-// part of the screen, or with additive colors (alpha = 0) as well.
+// part of the screen, or with additive colors (alpha = 0) as well. To fill many
+// rectangles at once, call Bind(), then Add() each one, then Unbind().
 class FillShader {
 public:
 	static void Init();
 	
 	static void Fill(const Point &center, const Point &size, const Color &color);
+	
+	static void Bind();
+	static void Add(const Point &center, const Point &size, const Color &color);
+	static void Unbind();
 };
 
 
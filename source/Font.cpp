@@ -28,24 +28,20 @@ namespace {
 	static const char *vertexCode =
 		// "scale" maps pixel coordinates to GL coordinates (-1 to 1).
 		"uniform vec2 scale;\n"
-		// The (x, y) coordinates of the top left corner of the glyph.
+		// The (x, y) coordinates of the top left corner of the string.
 		"uniform vec2 position;\n"
-		// The glyph to draw. (ASCII value - 32).
-		"uniform int glyph;\n"
-		// Aspect ratio of rendered glyph (unity by default).
-		"uniform float aspect = 1.f;\n"
 		
-		// Inputs from the VBO.
+		// Inputs from the VBO. Each string is laid out in advance as a list of
+		// glyph quads relative to its top left corner.
 		"in vec2 vert;\n"
-		"in vec2 corner;\n"
+		"in vec2 vertTexCoord;\n"
 		
 		// Output to the fragment shader.
 		"out vec2 texCoord;\n"
 		
-		// Pick the proper glyph out of the texture.
 		"void main() {\n"
-		"  texCoord = vec2((glyph + corner.x) / 98.f, corner.y);\n"
-		"  gl_Position = vec4((aspect * vert.x + position.x) * scale.x, (vert.y + position.y) * scale.y, 0, 1);\n"
+		"  texCoord = vertTexCoord;\n"
+		"  gl_Position = vec4((vert + position) * scale, 0, 1);\n"
 		"}\n";
 	
 	static const char *fragmentCode =
@@ -65,13 +61,23 @@ namespace {
 		"}\n";
 	
 	static const int KERN = 2;
+	
+	// Each glyph is drawn as two triangles, and each vertex has an (x, y)
+	// position and a texture coordinate.
+	static const int VERTICES_PER_GLYPH = 6;
+	static const int FLOATS_PER_VERTEX = 4;
+	// Initial and maximum size of the buffer in which laid-out strings are
+	// cached. The buffer grows each time it fills up, until it hits the limit.
+	static const int CACHE_GLYPHS = 8192;
+	static const int MAX_CACHE_GLYPHS = 65536;
 }
 
 
 
 Font::Font()
-	: texture(0), vao(0), vbo(0), colorI(0), scaleI(0), glyphI(0), aspectI(0),
-	  positionI(0), height(0), space(0), screenWidth(0), screenHeight(0)
+	: texture(0), vao(0), vbo(0), colorI(0), scaleI(0), positionI(0),
+	  height(0), space(0), glyphWidth(0.f), glyphHeight(0.f), screenWidth(0),
+	  screenHeight(0), used(0), capacity(0), meshUnderlines(false)
 {
 }
 
@@ -110,6 +116,28 @@ void Font::Draw(const string &str, const Point &point, const Color &color) const
 
 void Font::DrawAliased(const std::string &str, double x, double y, const Color &color) const
 {
+	// Look up or build the glyph quads for this string before binding anything
+	// else, because building a new mesh binds the vertex buffer.
+	DrawMesh(GetMesh(str, nullptr), x, y, color);
+}
+
+
+
+// Draw a block of words, each at the given offset from the top left corner,
+// with a single draw call. The key must uniquely identify the block's
+// contents, and must begin with a '\0' so it cannot match any plain string.
+void Font::DrawBlock(const string &key, const vector<pair<Point, const char *>> &words, const Point &point, const Color &color) const
+{
+	DrawMesh(GetMesh(key, &words), round(point.X()), round(point.Y()), color);
+}
+
+
+
+void Font::DrawMesh(const Mesh &mesh, double x, double y, const Color &color) const
+{
+	if(!mesh.count)
+		return;
+	
 	glUseProgram(shader.Object());
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, texture);
@@ -126,53 +154,10 @@ void Font::DrawAliased(const std::string &str, double x, double y, const Color &
 		glUniform2fv(scaleI, 1, scale);
 	}
 	
-	GLfloat textPos[2] = {
-		static_cast<float>(x - 1.),
-		static_cast<float>(y)};
-	int previous = 0;
-	bool isAfterSpace = true;
-	bool underlineChar = false;
-	const int underscoreGlyph = max(0, min(GLYPHS - 1, '_' - 32));
+	GLfloat textPos[2] = {static_cast<float>(x), static_cast<float>(y)};
+	glUniform2fv(positionI, 1, textPos);
 	
-	for(char c : str)
-	{
-		if(c == '_')
-		{
-			underlineChar = showUnderlines;
-			continue;
-		}
-		
-		int glyph = Glyph(c, isAfterSpace);
-		if(c != '"' && c != '\'')
-			isAfterSpace = !glyph;
-		if(!glyph)
-		{
-			textPos[0] += space;
-			continue;
-		}
-		
-		glUniform1i(glyphI, glyph);
-		glUniform1f(aspectI, 1.f);
-		
-		textPos[0] += advance[previous * GLYPHS + glyph] + KERN;
-		glUniform2fv(positionI, 1, textPos);
-		
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-		
-		if(underlineChar)
-		{
-			glUniform1i(glyphI, underscoreGlyph);
-			glUniform1f(aspectI, static_cast<float>(advance[glyph * GLYPHS] + KERN)
-				/ (advance[underscoreGlyph * GLYPHS] + KERN));
-			
-			glUniform2fv(positionI, 1, textPos);
-			
-			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-			underlineChar = false;
-		}
-		
-		previous = glyph;
-	}
+	glDrawArrays(GL_TRIANGLES, mesh.first, mesh.count);
 }
 
 
@@ -247,6 +232,121 @@ int Font::Glyph(char c, bool isAfterSpace)
 
 
 
+// Get the cached vertex data for the given string (or block of words, if
+// given), laying it out and adding it to the vertex buffer if it has not been
+// drawn recently.
+const Font::Mesh &Font::GetMesh(const string &key, const vector<pair<Point, const char *>> *words) const
+{
+	// Whether underscores are shown changes the layout of every string.
+	if(meshUnderlines != showUnderlines)
+	{
+		meshUnderlines = showUnderlines;
+		meshes.clear();
+		used = 0;
+	}
+	
+	auto it = meshes.find(key);
+	if(it != meshes.end())
+		return it->second;
+	
+	layout.clear();
+	if(!words)
+		Layout(key.c_str(), 0.f, 0.f, layout);
+	else
+		for(const auto &word : *words)
+			Layout(word.second, word.first.X(), word.first.Y(), layout);
+	GLsizei count = layout.size() / FLOATS_PER_VERTEX;
+	
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	if(used + count > capacity)
+	{
+		// The buffer is full. Rather than tracking which strings are still in
+		// use, just throw out the whole cache. Reallocating the buffer lets the
+		// driver give us new storage instead of waiting for pending draws.
+		meshes.clear();
+		used = 0;
+		capacity = max(count, min(2 * capacity, MAX_CACHE_GLYPHS * VERTICES_PER_GLYPH));
+		glBufferData(GL_ARRAY_BUFFER, capacity * FLOATS_PER_VERTEX * sizeof(GLfloat),
+			nullptr, GL_DYNAMIC_DRAW);
+	}
+	if(count)
+		glBufferSubData(GL_ARRAY_BUFFER, used * FLOATS_PER_VERTEX * sizeof(GLfloat),
+			layout.size() * sizeof(GLfloat), layout.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	
+	Mesh &mesh = meshes[key];
+	mesh.first = used;
+	mesh.count = count;
+	used += count;
+	return mesh;
+}
+
+
+
+// Lay out the given string, with its top left corner at the given offset, as a
+// list of glyph quads. This applies the same kerning as Width().
+void Font::Layout(const char *str, float x, float y, vector<GLfloat> &vertices) const
+{
+	float textX = x - 1.f;
+	int previous = 0;
+	bool isAfterSpace = true;
+	bool underlineChar = false;
+	const int underscoreGlyph = max(0, min(GLYPHS - 1, '_' - 32));
+	
+	for( ; *str; ++str)
+	{
+		char c = *str;
+		if(c == '_')
+		{
+			underlineChar = showUnderlines;
+			continue;
+		}
+		
+		int glyph = Glyph(c, isAfterSpace);
+		if(c != '"' && c != '\'')
+			isAfterSpace = !glyph;
+		if(!glyph)
+		{
+			textX += space;
+			continue;
+		}
+		
+		textX += advance[previous * GLYPHS + glyph] + KERN;
+		AddGlyph(vertices, glyph, textX, y, 1.f);
+		
+		// The underline is an underscore stretched to this character's width.
+		if(underlineChar)
+		{
+			float aspect = static_cast<float>(advance[glyph * GLYPHS] + KERN)
+				/ (advance[underscoreGlyph * GLYPHS] + KERN);
+			AddGlyph(vertices, underscoreGlyph, textX, y, aspect);
+			underlineChar = false;
+		}
+		
+		previous = glyph;
+	}
+}
+
+
+
+void Font::AddGlyph(vector<GLfloat> &vertices, int glyph, float x, float y, float aspect) const
+{
+	// Corners of the two triangles making up the glyph's quad.
+	static const float CORNERS[VERTICES_PER_GLYPH][2] = {
+		{0.f, 0.f}, {0.f, 1.f}, {1.f, 0.f},
+		{0.f, 1.f}, {1.f, 1.f}, {1.f, 0.f}
+	};
+	for(const float *corner : CORNERS)
+	{
+		vertices.push_back(x + aspect * glyphWidth * corner[0]);
+		vertices.push_back(y + glyphHeight * corner[1]);
+		vertices.push_back((glyph + corner[0]) / GLYPHS);
+		vertices.push_back(corner[1]);
+	}
+}
+
+
+
 void Font::LoadTexture(ImageBuffer *image)
 {
 	glGenTextures(1, &texture);
@@ -327,8 +427,8 @@ void Font::CalculateAdvances(ImageBuffer *image)
 
 void Font::SetUpShader(float glyphW, float glyphH)
 {
-	glyphW *= .5f;
-	glyphH *= .5f;
+	glyphWidth = glyphW * .5f;
+	glyphHeight = glyphH * .5f;
 	
 	shader = Shader(vertexCode, fragmentCode);
 	glUseProgram(shader.Object());
@@ -340,22 +440,24 @@ void Font::SetUpShader(float glyphW, float glyphH)
 	glGenBuffers(1, &vbo);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	
-	GLfloat vertices[] = {
-		   0.f,    0.f, 0.f, 0.f,
-		   0.f, glyphH, 0.f, 1.f,
-		glyphW,    0.f, 1.f, 0.f,
-		glyphW, glyphH, 1.f, 1.f
-	};
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	// The buffer is filled in as strings are drawn.
+	meshes.clear();
+	used = 0;
+	capacity = CACHE_GLYPHS * VERTICES_PER_GLYPH;
+	glBufferData(GL_ARRAY_BUFFER, capacity * FLOATS_PER_VERTEX * sizeof(GLfloat),
+		nullptr, GL_DYNAMIC_DRAW);
 	
 	// connect the xy to the "vert" attribute of the vertex shader
 	glEnableVertexAttribArray(shader.Attrib("vert"));
 	glVertexAttribPointer(shader.Attrib("vert"), 2, GL_FLOAT, GL_FALSE,
-		4 * sizeof(GLfloat), NULL);
+		FLOATS_PER_VERTEX * sizeof(GLfloat), NULL);
+	
+	glEnableVertexAttribArray(shader.Attrib("vertTexCoord"));
+	glVertexAttribPointer(shader.Attrib("vertTexCoord"), 2, GL_FLOAT, GL_FALSE,
+		FLOATS_PER_VERTEX * sizeof(GLfloat), (const GLvoid*)(2 * sizeof(GLfloat)));
 	
-	glEnableVertexAttribArray(shader.Attrib("corner"));
-	glVertexAttribPointer(shader.Attrib("corner"), 2, GL_FLOAT, GL_FALSE,
-		4 * sizeof(GLfloat), (const GLvoid*)(2 * sizeof(GLfloat)));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
 	
 	// We must update the screen size next time we draw.
 	screenWidth = 0;
@@ -366,7 +468,5 @@ void Font::SetUpShader(float glyphW, float glyphH)
 
 	colorI = shader.Uniform("color");
 	scaleI = shader.Uniform("scale");
-	glyphI = shader.Uniform("glyph");
-	aspectI = shader.Uniform("aspect");
 	positionI = shader.Uniform("position");
 }
@@ -13,22 +13,27 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef FONT_H_
 #define FONT_H_
 
+#include "Point.h"
 #include "Shader.h"
 
 #include "gl_header.h"
 
+#include <map>
 #include <string>
+#include <utility>
+#include <vector>
 
 class Color;
 class ImageBuffer;
-class Point;
 
 
 
 // Class for drawing text in OpenGL. Each font is based on a single image with
 // glyphs for each character in ASCII order (not counting control characters).
 // The kerning between characters is automatically adjusted to look good. At the
-// moment only plain ASCII characters are supported, not Unicode.
+// moment only plain ASCII characters are supported, not Unicode. Each string is
+// laid out once into a buffer of glyph quads and cached, so drawing it again
+// takes a single draw call.
 class Font {
 public:
 	Font();
@@ -38,6 +43,10 @@ public:
 	
 	void Draw(const std::string &str, const Point &point, const Color &color) const;
 	void DrawAliased(const std::string &str, double x, double y, const Color &color) const;
+	// Draw a block of words, each at the given offset from the top left corner,
+	// with a single draw call. The key must uniquely identify the block's
+	// contents, and must begin with a '\0' so it cannot match any plain string.
+	void DrawBlock(const std::string &key, const std::vector<std::pair<Point, const char *>> &words, const Point &point, const Color &color) const;
 	
 	int Width(const std::string &str, char after = ' ') const;
 	int Width(const char *str, char after = ' ') const;
@@ -49,8 +58,21 @@ public:
 	static void ShowUnderlines(bool show);
 	
 	
+private:
+	// The location of a laid-out string within the vertex buffer.
+	class Mesh {
+	public:
+		GLint first;
+		GLsizei count;
+	};
+	
+	
 private:
 	static int Glyph(char c, bool isAfterSpace);
+	void DrawMesh(const Mesh &mesh, double x, double y, const Color &color) const;
+	const Mesh &GetMesh(const std::string &key, const std::vector<std::pair<Point, const char *>> *words) const;
+	void Layout(const char *str, float x, float y, std::vector<GLfloat> &vertices) const;
+	void AddGlyph(std::vector<GLfloat> &vertices, int glyph, float x, float y, float aspect) const;
 	void LoadTexture(ImageBuffer *image);
 	void CalculateAdvances(ImageBuffer *image);
 	void SetUpShader(float glyphW, float glyphH);
@@ -64,15 +86,22 @@ private:
 	
 	GLint colorI;
 	GLint scaleI;
-	GLint glyphI;
-	GLint aspectI;
 	GLint positionI;
 	
 	int height;
 	int space;
+	float glyphWidth;
+	float glyphHeight;
 	mutable int screenWidth;
 	mutable int screenHeight;
 	
+	// Strings that have been laid out, and how much of the buffer they fill.
+	mutable std::map<std::string, Mesh> meshes;
+	mutable std::vector<GLfloat> layout;
+	mutable GLsizei used;
+	mutable GLsizei capacity;
+	mutable bool meshUnderlines;
+	
 	static const int GLYPHS = 98;
 	int advance[GLYPHS * GLYPHS];
 };
@@ -12,21 +12,26 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "GameData.h"
 
+#include "AssetManifest.h"
 #include "Audio.h"
 #include "Color.h"
 #include "Command.h"
 #include "Conversation.h"
+#include "CookedImage.h"
+#include "DataCache.h"
 #include "DataFile.h"
 #include "DataNode.h"
 #include "DataWriter.h"
 #include "Effect.h"
 #include "Files.h"
+#include "FileWatcher.h"
 #include "FillShader.h"
 #include "Fleet.h"
 #include "FontSet.h"
 #include "Galaxy.h"
 #include "GameEvent.h"
 #include "Government.h"
+#include "ImageBuffer.h"
 #include "Interface.h"
 #include "LineShader.h"
 #include "Mission.h"
@@ -35,31 +40,48 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Person.h"
 #include "Phrase.h"
 #include "Planet.h"
+#include "PlayerInfo.h"
 #include "PointerShader.h"
 #include "Politics.h"
 #include "RingShader.h"
 #include "Sale.h"
+#include "Screen.h"
 #include "Set.h"
 #include "Ship.h"
+#include "Sprite.h"
 #include "SpriteQueue.h"
+#include "SpriteResidency.h"
 #include "SpriteSet.h"
 #include "SpriteShader.h"
+#include "StartupProfile.h"
 #include "StarField.h"
 #include "StartConditions.h"
+#include "StellarObject.h"
 #include "System.h"
 
+#include <SDL2/SDL.h>
+
 #include <algorithm>
+#include <atomic>
+#include <cstdlib>
 #include <iostream>
 #include <map>
-#include <tuple>
+#include <memory>
+#include <set>
+#include <thread>
 #include <utility>
 #include <vector>
 
-class Sprite;
-
 using namespace std;
 
 namespace {
+	template <class Type>
+	void PrintUndefined(const string &kind, const Set<Type> &set)
+	{
+		for(const string &name : set.Undefined())
+			Files::LogError("Warning: " + kind + " \"" + name + "\" is referred to, but never defined.");
+	}
+	
 	Set<Color> colors;
 	Set<Conversation> conversations;
 	Set<Effect> effects;
@@ -95,12 +117,92 @@ namespace {
 	StarField background;
 	
 	SpriteQueue spriteQueue;
+	SpriteResidency residency(spriteQueue);
+	bool debugMode = false;
+	// In debug mode, data files and images are reloaded when they change.
+	unique_ptr<FileWatcher> watcher;
+	// The objects that each data file defines, and the order in which the files
+	// were loaded, so that an object defined by several files (e.g. in a plugin
+	// that overrides it) can be rebuilt from all of them when one changes.
+	vector<string> loadOrder;
+	map<string, set<pair<string, string>>> definitions;
 	
 	vector<string> sources;
-	multimap<const Sprite *, pair<string, string>> deferred;
-	multimap<const Sprite *, tuple<string, string, int>> preloaded;
+	// Whether to load @2x images. If not, each @2x image is only loaded if it
+	// has no @1x version, and then it is loaded at half size in its place.
+	bool loadHighDPI = true;
+	// The @2x images that have not been loaded at full size, in case it turns
+	// out that they are needed after all.
+	vector<pair<string, string>> skippedHighDPI;
 	
 	const Government *playerGovernment = nullptr;
+	
+	// Below this many pixels per inch, a display is probably not high DPI.
+	const float HIGH_DPI = 150.f;
+	// By default, allow this many megabytes of sprite textures to be loaded.
+	const int DEFAULT_TEXTURE_BUDGET = 512;
+	
+	// Parse all the given data files, using one thread per processor core.
+	vector<DataFile> ParseAll(const vector<string> &paths)
+	{
+		// The files are all created up front, so that none of them move once
+		// they are loaded; each DataNode refers to its parent.
+		vector<DataFile> files(paths.size());
+		atomic<size_t> next(0);
+		auto parse = [&paths, &files, &next]()
+		{
+			for(size_t i = next++; i < paths.size(); i = next++)
+			{
+				StartupProfile::Phase phase("parse data file", paths[i]);
+				files[i].Load(paths[i]);
+			}
+		};
+		
+		// If the number of cores is not known, fall back to four threads.
+		unsigned count = thread::hardware_concurrency();
+		vector<thread> threads(min<size_t>(count ? count : 4, paths.size()));
+		for(thread &t : threads)
+			t = thread(parse);
+		for(thread &t : threads)
+			t.join();
+		
+		return files;
+	}
+	
+	// Get the type and name of the object that the given root node defines.
+	// Ship variants are named by their third token.
+	pair<string, string> Definition(const DataNode &node)
+	{
+		if(node.Token(0) == "ship" && node.Size() > 2)
+			return make_pair(node.Token(0), node.Token(2));
+		return make_pair(node.Token(0), node.Size() >= 2 ? node.Token(1) : string());
+	}
+	
+	// Store a copy of the given set, to revert back to later.
+	template <class Type>
+	void Snapshot(Set<Type> &copy, const Set<Type> &original, const char *name)
+	{
+		StartupProfile::Phase phase("copy default state", name);
+		copy = original;
+	}
+	
+	// Check whether the given cooked image was made with the same settings
+	// that CookImages() would use now. Frames that will go into an atlas are
+	// neither mipmapped nor compressed; bigger ones are always mipmapped, and
+	// compressed only if that was asked for.
+	bool IsCooked(const string &path, bool compress)
+	{
+		int width = 0;
+		int height = 0;
+		int levels = 0;
+		CookedImage::Format format = CookedImage::BGRA;
+		if(!CookedImage::ReadHeader(path, width, height, format, levels))
+			return false;
+		
+		bool isBig = !Sprite::FitsAtlas(width, height);
+		bool isCompressed = (format != CookedImage::BGRA);
+		return ((levels > 1) == isBig && isCompressed == (compress && isBig));
+	}
 }
 
 
@@ -109,7 +211,9 @@ void GameData::BeginLoad(const char * const *argv)
 {
 	bool printShips = false;
 	bool printWeapons = false;
-	bool debugMode = false;
+	bool useDataCache = true;
+	bool verifyDataCache = false;
+	int textureBudget = DEFAULT_TEXTURE_BUDGET;
 	for(const char * const *it = argv + 1; *it; ++it)
 	{
 		if((*it)[0] == '-')
@@ -121,56 +225,179 @@ void GameData::BeginLoad(const char * const *argv)
 				printWeapons = true;
 			if(arg == "-d" || arg == "--debug")
 				debugMode = true;
+			if(arg == "--loader-threads" && it[1])
+				spriteQueue.SetThreadCount(atoi(*++it));
+			if(arg == "--texture-budget" && it[1])
+				textureBudget = atoi(*++it);
+			if(arg == "--no-data-cache")
+				useDataCache = false;
+			if(arg == "--verify-data-cache")
+				verifyDataCache = true;
 			continue;
 		}
 	}
-	Files::Init(argv);
+	residency.SetBudget(static_cast<int64_t>(textureBudget) << 20);
+	{
+		StartupProfile::Phase phase("Files::Init");
+		Files::Init(argv);
+	}
+	
+	// Find every file in the game's resources and plugins. Any directory that
+	// has not changed since the last time the game was run is not listed again.
+	AssetManifest::Init({
+		Files::Resources() + "data/",
+		Files::Resources() + "images/",
+		Files::Resources() + "cooked/",
+		Files::Resources() + "sounds/",
+		Files::Resources() + "plugins/",
+		Files::Config() + "plugins/"});
 	
 	// Initialize the list of "source" folders based on any active plugins.
-	LoadSources();
+	{
+		StartupProfile::Phase phase("LoadSources");
+		LoadSources();
+	}
 	
 	// Now, read all the images in all the path directories. For each unique
 	// name, only remember one instance, letting things on the higher priority
 	// paths override the default images.
 	map<string, string> images;
-	LoadImages(images);
+	{
+		StartupProfile::Phase phase("LoadImages");
+		LoadImages(images);
+	}
+	
+	// Decide now whether the @2x images will be needed, so that on an ordinary
+	// display they are never read from disk at all. They are needed whenever
+	// Screen::IsHighResolution() is true, but the window does not exist yet, so
+	// also go by the pixel density that the display reports. If this guess is
+	// wrong, or the player zooms in later, LoadHighDPI() loads them then.
+	float dpi = 0.f;
+	loadHighDPI = Screen::IsHighResolution()
+		|| (!SDL_GetDisplayDPI(0, &dpi, nullptr, nullptr) && dpi >= HIGH_DPI);
 	
-	// From the name, strip out any frame number, plus the extension.
-	for(const auto &it : images)
+	// From the name, strip out any frame number, plus the extension. Most
+	// sprites are not actually loaded until they are needed.
 	{
-		string name = Name(it.first);
-		if(name.substr(0, 5) == "land/")
-			deferred.emplace(SpriteSet::Get(name), pair<string, string>(name, it.second));
-		else
-			spriteQueue.Add(name, it.second);
+		StartupProfile::Phase phase("add sprites");
+		for(const auto &it : images)
+		{
+			string name = Name(it.first);
+			bool is2x = SpriteQueue::Is2x(it.first);
+			if(!loadHighDPI && is2x)
+			{
+				// If there is an @1x version of this image, skip it. Otherwise it
+				// is loaded at half size instead.
+				string base = it.first;
+				base.erase(base.length() - 7, 3);
+				skippedHighDPI.emplace_back(name, it.second);
+				if(images.count(base))
+					continue;
+			}
+			residency.Add(name, it.second, !loadHighDPI && is2x);
+		}
 	}
 	
-	for(const string &source : sources)
+	// Iterate through the paths starting with the last directory given. That
+	// is, things in folders near the start of the path have the ability to
+	// override things in folders later in the path.
+	vector<string> dataPaths;
 	{
-		// Iterate through the paths starting with the last directory given. That
-		// is, things in folders near the start of the path have the ability to
-		// override things in folders later in the path.
-		vector<string> dataFiles = Files::RecursiveList(source + "data/");
-		for(const string &path : dataFiles)
-			LoadFile(path, debugMode);
+		StartupProfile::Phase phase("list data files");
+		for(const string &source : sources)
+			for(const string &path : AssetManifest::RecursiveList(source + "data/"))
+				if(path.length() >= 4 && !path.compare(path.length() - 4, 4, ".txt"))
+					dataPaths.push_back(path);
 	}
 	
+	// If none of the files have changed since the last time the game was run,
+	// their parsed form can be read straight from the cache. Otherwise, parsing
+	// the files is independent of the game data, so it can be done by several
+	// threads at once. The results must be applied in order, though.
+	string cachePath = Files::Config() + "data.cache";
+	vector<DataFile> dataFiles;
+	bool isCached = false;
+	if(useDataCache || verifyDataCache)
+	{
+		StartupProfile::Phase phase("read data cache");
+		isCached = DataCache::Read(cachePath, dataPaths, dataFiles);
+	}
+	if(verifyDataCache)
+	{
+		if(!isCached)
+			Files::LogError("Data cache verification: the cache is missing or out of date.");
+		else
+		{
+			// Make sure that the cache holds exactly what parsing the files gives.
+			vector<DataFile> parsed = ParseAll(dataPaths);
+			int mismatches = 0;
+			for(size_t i = 0; i < parsed.size(); ++i)
+				if(!DataCache::IsSame(dataFiles[i], parsed[i]))
+				{
+					Files::LogError("Data cache verification: mismatch in " + dataPaths[i]);
+					++mismatches;
+				}
+			Files::LogError("Data cache verification: " + to_string(dataPaths.size()) + " files checked, "
+				+ to_string(mismatches) + " mismatched.");
+			if(mismatches)
+				dataFiles = move(parsed);
+			isCached = !mismatches;
+		}
+	}
+	if(!isCached)
+	{
+		// If the cache did not match, the files have already been parsed.
+		if(dataFiles.size() != dataPaths.size())
+		{
+			StartupProfile::Phase phase("parse data files");
+			dataFiles = ParseAll(dataPaths);
+		}
+		if(useDataCache)
+		{
+			StartupProfile::Phase phase("write data cache");
+			if(!DataCache::Write(cachePath, dataPaths, dataFiles))
+				Files::LogError("Unable to write the data cache: " + cachePath);
+		}
+	}
+	{
+		StartupProfile::Phase phase("apply data files");
+		for(size_t i = 0; i < dataFiles.size(); ++i)
+		{
+			if(debugMode)
+			{
+				Files::LogError("Parsing: " + dataPaths[i]);
+				loadOrder.push_back(dataPaths[i]);
+				set<pair<string, string>> &defined = definitions[dataPaths[i]];
+				for(const DataNode &node : dataFiles[i])
+					defined.insert(Definition(node));
+			}
+			LoadFile(dataFiles[i]);
+		}
+	}
+	dataFiles.clear();
+	
 	// Now that all the stars are loaded, update the neighbor lists.
-	for(auto &it : systems)
-		it.second.UpdateNeighbors(systems);
+	{
+		StartupProfile::Phase phase("UpdateNeighbors");
+		for(auto &it : systems)
+			it.second.UpdateNeighbors(systems);
+	}
 	// And, update the ships with the outfits we've now finished loading.
-	for(auto &it : ships)
-		it.second.FinishLoading();
-	for(const auto &it : persons)
-		it.second.GetShip()->FinishLoading();
+	{
+		StartupProfile::Phase phase("Ship::FinishLoading");
+		for(auto &it : ships)
+			it.second.FinishLoading();
+		for(const auto &it : persons)
+			it.second.GetShip()->FinishLoading();
+	}
 	
 	// Store the current state, to revert back to later.
-	defaultFleets = fleets;
-	defaultGovernments = governments;
-	defaultPlanets = planets;
-	defaultSystems = systems;
-	defaultShipSales = shipSales;
-	defaultOutfitSales = outfitSales;
+	Snapshot(defaultFleets, fleets, "fleets");
+	Snapshot(defaultGovernments, governments, "governments");
+	Snapshot(defaultPlanets, planets, "planets");
+	Snapshot(defaultSystems, systems, "systems");
+	Snapshot(defaultShipSales, shipSales, "shipyards");
+	Snapshot(defaultOutfitSales, outfitSales, "outfitters");
 	playerGovernment = governments.Get("Escort");
 	
 	politics.Reset();
@@ -179,6 +406,248 @@ void GameData::BeginLoad(const char * const *argv)
 		PrintShipTable();
 	if(printWeapons)
 		PrintWeaponTable();
+	if(debugMode)
+	{
+		CheckReferences();
+		
+		vector<string> watched;
+		for(const string &source : sources)
+		{
+			watched.push_back(source + "data/");
+			watched.push_back(source + "images/");
+		}
+		watcher.reset(new FileWatcher(watched));
+	}
+}
+
+
+
+// In debug mode, reload any data files or images that have been changed since
+// the last time this was called.
+void GameData::ReloadChanges()
+{
+	if(!watcher)
+		return;
+	
+	// Find every object that a changed data file defines, or used to define.
+	set<pair<string, string>> changed;
+	for(const string &path : watcher->Changes())
+		for(const string &source : sources)
+		{
+			string dataPath = source + "data/";
+			string imagePath = source + "images/";
+			if(!path.compare(0, dataPath.length(), dataPath))
+			{
+				if(path.length() < 4 || path.compare(path.length() - 4, 4, ".txt"))
+					break;
+				
+				Files::LogError("Reloading: " + path);
+				auto it = definitions.find(path);
+				if(it == definitions.end())
+				{
+					// A new file is loaded after all the others.
+					loadOrder.push_back(path);
+					it = definitions.emplace(path, set<pair<string, string>>()).first;
+				}
+				changed.insert(it->second.begin(), it->second.end());
+				it->second.clear();
+				DataFile file(path);
+				for(const DataNode &node : file)
+					it->second.insert(Definition(node));
+				changed.insert(it->second.begin(), it->second.end());
+				break;
+			}
+			if(!path.compare(0, imagePath.length(), imagePath))
+			{
+				bool isJpg = (path.length() >= 4 && !path.compare(path.length() - 4, 4, ".jpg"));
+				bool isPng = (path.length() >= 4 && !path.compare(path.length() - 4, 4, ".png"));
+				if(!isJpg && !isPng)
+					break;
+				
+				// If this image was cooked, the cooked texture is now out of date.
+				Files::LogError("Reloading: " + path);
+				string relative = path.substr(imagePath.length());
+				string name = Name(relative);
+				if(!residency.Reload(name, path, source + "cooked/" + relative + ".tex"))
+				{
+					// This is a new image.
+					if(!loadHighDPI && SpriteQueue::Is2x(path))
+						skippedHighDPI.emplace_back(name, path);
+					else
+						residency.Add(name, path, false);
+				}
+				break;
+			}
+		}
+	if(changed.empty())
+		return;
+	
+	// Most objects replace their old definitions when they are loaded again,
+	// but these add to them instead, so they must be cleared first.
+	for(const pair<string, string> &it : changed)
+	{
+		const string &key = it.first;
+		const string &name = it.second;
+		if(name.empty())
+			continue;
+		if(key == "event")
+			*events.Get(name) = GameEvent();
+		else if(key == "mission")
+			*missions.Get(name) = Mission();
+		else if(key == "outfit")
+			*outfits.Get(name) = Outfit();
+		else if(key == "outfitter")
+			*outfitSales.Get(name) = Sale<Outfit>();
+		else if(key == "phrase")
+			*phrases.Get(name) = Phrase();
+		else if(key == "planet")
+			*planets.Get(name) = Planet();
+		else if(key == "shipyard")
+			*shipSales.Get(name) = Sale<Ship>();
+	}
+	
+	// Apply every definition of those objects again, from every file that has
+	// one, in the order the files were first loaded. That way, a plugin that
+	// overrides part of an object still does so after the base file changes.
+	for(const string &path : loadOrder)
+	{
+		const set<pair<string, string>> &defined = definitions[path];
+		bool isAffected = false;
+		for(const pair<string, string> &it : defined)
+			isAffected |= (changed.count(it) != 0);
+		if(!isAffected)
+			continue;
+		
+		DataFile file(path);
+		for(const DataNode &node : file)
+			if(changed.count(Definition(node)))
+				LoadNode(node);
+	}
+	
+	// The systems that a planet is in are set when the systems are loaded, so
+	// any planet that was reset must be told again which systems it is in.
+	for(const auto &it : systems)
+		for(const StellarObject &object : it.second.Objects())
+			if(object.GetPlanet() && changed.count(make_pair(string("planet"), object.GetPlanet()->Name())))
+				planets.Get(object.GetPlanet()->Name())->SetSystem(&it.second);
+	
+	bool updateSystems = false;
+	bool updateAllShips = false;
+	for(const pair<string, string> &it : changed)
+	{
+		updateSystems |= (it.first == "system");
+		updateAllShips |= (it.first == "outfit");
+	}
+	if(updateSystems)
+		for(auto &it : systems)
+			it.second.UpdateNeighbors(systems);
+	if(updateAllShips)
+	{
+		for(auto &it : ships)
+			it.second.FinishLoading();
+		for(const auto &it : persons)
+			it.second.GetShip()->FinishLoading();
+	}
+	
+	// Update the state that is restored when another pilot is loaded, so that
+	// doing so does not undo these changes. This must wait until the systems'
+	// neighbors and the planets' systems are up to date.
+	for(const pair<string, string> &it : changed)
+	{
+		const string &key = it.first;
+		const string &name = it.second;
+		if(name.empty())
+			continue;
+		if(key == "ship" && !updateAllShips)
+			ships.Get(name)->FinishLoading();
+		else if(key == "fleet")
+			*defaultFleets.Get(name) = *fleets.Get(name);
+		else if(key == "government")
+			*defaultGovernments.Get(name) = *governments.Get(name);
+		else if(key == "planet")
+			*defaultPlanets.Get(name) = *planets.Get(name);
+		else if(key == "system")
+			*defaultSystems.Get(name) = *systems.Get(name);
+		else if(key == "shipyard")
+			*defaultShipSales.Get(name) = *shipSales.Get(name);
+		else if(key == "outfitter")
+			*defaultOutfitSales.Get(name) = *outfitSales.Get(name);
+	}
+}
+
+
+
+// In debug mode, report any objects that have been looked up by name (in the
+// data files or by the game itself) but that were never actually defined.
+void GameData::CheckReferences()
+{
+	PrintUndefined("color", colors);
+	PrintUndefined("conversation", conversations);
+	PrintUndefined("effect", effects);
+	PrintUndefined("event", events);
+	PrintUndefined("fleet", fleets);
+	PrintUndefined("galaxy", galaxies);
+	PrintUndefined("government", governments);
+	PrintUndefined("interface", interfaces);
+	PrintUndefined("mission", missions);
+	PrintUndefined("outfit", outfits);
+	PrintUndefined("outfitter", outfitSales);
+	PrintUndefined("person", persons);
+	PrintUndefined("phrase", phrases);
+	PrintUndefined("planet", planets);
+	PrintUndefined("ship", ships);
+	PrintUndefined("shipyard", shipSales);
+	PrintUndefined("system", systems);
+	
+	// Sprites are defined by their image files, whether or not they have been
+	// loaded yet.
+	for(const string &name : SpriteSet::Undefined())
+		Files::LogError("Warning: sprite \"" + name + "\" is referred to, but has no image.");
+}
+
+
+
+// Convert every image into a cooked texture in the "cooked" folder next to it.
+void GameData::CookImages(const char * const *argv, bool compress)
+{
+	Files::Init(argv);
+	LoadSources();
+	
+	int cooked = 0;
+	int skipped = 0;
+	for(const string &source : sources)
+	{
+		string directoryPath = source + "images/";
+		string cookedPath = source + "cooked/";
+		for(const string &path : Files::RecursiveList(directoryPath))
+		{
+			string target = cookedPath + path.substr(directoryPath.length()) + ".tex";
+			if(Files::Timestamp(target) >= Files::Timestamp(path) && IsCooked(target, compress))
+			{
+				++skipped;
+				continue;
+			}
+			ImageBuffer *image = ImageBuffer::Read(path);
+			if(!image)
+				continue;
+			
+			// Frames that will go into an atlas are left as they are, because the
+			// atlas is neither mipmapped nor compressed.
+			bool isBig = !Sprite::FitsAtlas(image->Width(), image->Height());
+			CookedImage *result = CookedImage::Cook(*image, isBig, compress && isBig);
+			delete image;
+			if(!result)
+				continue;
+			
+			Files::CreateFolder(target.substr(0, target.rfind('/')));
+			if(result->Write(target))
+				++cooked;
+			else
+				Files::LogError("Unable to write cooked image \"" + target + "\".");
+			delete result;
+		}
+	}
+	cout << "Cooked " << cooked << " images (" << skipped << " already up to date)." << endl;
 }
 
 
@@ -206,52 +675,55 @@ void GameData::LoadShaders()
 
 double GameData::Progress()
 {
-	return min(spriteQueue.Progress(), Audio::Progress());
+	return min(spriteQueue.Completion(), Audio::Progress());
 }
 
 
 
-// Begin loading a sprite that was previously deferred. Currently this is
-// done with all landscapes to speed up the program's startup.
-void GameData::Preload(const Sprite *sprite)
+// Load the sprites that the player will see first before anything else: the
+// objects in their current system, then their ships.
+void GameData::Prioritize(const PlayerInfo &player)
 {
-	auto loadedRange = preloaded.equal_range(sprite);
-	if(loadedRange.first != loadedRange.second)
-	{
-		int priority = get<2>(loadedRange.first->second);
-		for(auto &it : preloaded)
-			if(get<2>(it.second) < priority)
-				++get<2>(it.second);
-		for( ; loadedRange.first != loadedRange.second; ++loadedRange.first)
-			get<2>(loadedRange.first->second) = 0;
-	}
+	if(player.GetSystem())
+		for(const StellarObject &object : player.GetSystem()->Objects())
+			residency.Load(object.GetSprite().GetSprite(), SpriteQueue::INTERFACE);
 	
-	auto range = deferred.equal_range(sprite);
-	if(range.first == range.second)
-		return;
-	
-	// Remove the oldest thing in the priority queue if it has grown big enough.
-	vector<multimap<const Sprite *, tuple<string, string, int>>::iterator> toErase;
-	for(auto it = preloaded.begin(); it != preloaded.end(); ++it)
-		if(++get<2>(it->second) >= 20)
-			toErase.push_back(it);
-	while(!toErase.empty())
-	{
-		const auto &next = *toErase.back();
-		deferred.emplace(next.first, make_pair(get<0>(next.second), get<1>(next.second)));
-		spriteQueue.Unload(get<0>(toErase.back()->second));
-		preloaded.erase(toErase.back());
-		toErase.pop_back();
-	}
-	
-	// Load this new sprite.
-	for(auto it = range.first; it != range.second; ++it)
+	for(const shared_ptr<Ship> &ship : player.Ships())
+		residency.Load(ship->GetSprite().GetSprite(), SpriteQueue::PLAYER);
+}
+
+
+
+// If BeginLoad() skipped the @2x images but they turn out to be needed, because
+// this is a high DPI display or because the zoom is above 100%, load them.
+void GameData::LoadHighDPI()
+{
+	loadHighDPI = true;
+}
+
+
+
+// Load the given sprite, if it is not loaded already, because it is likely
+// to be drawn soon.
+void GameData::Preload(const Sprite *sprite, bool isUrgent)
+{
+	residency.Load(sprite, isUrgent ? SpriteQueue::IMMEDIATE : SpriteQueue::INTERFACE);
+}
+
+
+
+// Load any sprites that have been drawn but not loaded, and unload the least
+// recently used ones if they take up too much memory.
+void GameData::StepSprites()
+{
+	// Adding the @2x images changes the sprites, so it must wait until now.
+	if(loadHighDPI && !skippedHighDPI.empty())
 	{
-		spriteQueue.Add(it->second.first, it->second.second);
-		preloaded.emplace(sprite, make_tuple(it->second.first, it->second.second, 0));
+		for(const pair<string, string> &it : skippedHighDPI)
+			residency.Add(it.first, it.second, false);
+		skippedHighDPI.clear();
 	}
-	
-	deferred.erase(range.first, range.second);
+	residency.Step();
 }
 
 
@@ -263,6 +735,22 @@ void GameData::FinishLoading()
 
 
 
+// Report how many sprites are loaded, and how much memory they use.
+void GameData::PrintSpriteReport()
+{
+	residency.PrintReport();
+}
+
+
+
+// Check whether the game was started with the "--debug" flag.
+bool GameData::DebugMode()
+{
+	return debugMode;
+}
+
+
+
 // Get the list of resource sources (i.e. plugin folders).
 const vector<string> &GameData::Sources()
 {
@@ -424,17 +912,17 @@ void GameData::AddPurchase(const System &system, const string &commodity, int to
 void GameData::Change(const DataNode &node)
 {
 	if(node.Token(0) == "fleet" && node.Size() >= 2)
-		fleets.Get(node.Token(1))->Load(node);
+		fleets.Define(node.Token(1))->Load(node);
 	else if(node.Token(0) == "government" && node.Size() >= 2)
-		governments.Get(node.Token(1))->Load(node);
+		governments.Define(node.Token(1))->Load(node);
 	else if(node.Token(0) == "outfitter" && node.Size() >= 2)
-		outfitSales.Get(node.Token(1))->Load(node, outfits);
+		outfitSales.Define(node.Token(1))->Load(node, outfits);
 	else if(node.Token(0) == "planet" && node.Size() >= 2)
-		planets.Get(node.Token(1))->Load(node, shipSales, outfitSales);
+		planets.Define(node.Token(1))->Load(node, shipSales, outfitSales);
 	else if(node.Token(0) == "shipyard" && node.Size() >= 2)
-		shipSales.Get(node.Token(1))->Load(node, ships);
+		shipSales.Define(node.Token(1))->Load(node, ships);
 	else if(node.Token(0) == "system" && node.Size() >= 2)
-		systems.Get(node.Token(1))->Load(node, planets);
+		systems.Define(node.Token(1))->Load(node, planets);
 	else if(node.Token(0) == "link" && node.Size() >= 3)
 		systems.Get(node.Token(1))->Link(systems.Get(node.Token(2)));
 	else if(node.Token(0) == "unlink" && node.Size() >= 3)
@@ -597,82 +1085,79 @@ void GameData::LoadSources()
 	sources.clear();
 	sources.push_back(Files::Resources());
 	
-	vector<string> globalPlugins = Files::ListDirectories(Files::Resources() + "plugins/");
+	vector<string> globalPlugins = AssetManifest::ListDirectories(Files::Resources() + "plugins/");
 	for(const string &path : globalPlugins)
 	{
-		if(Files::Exists(path + "data") || Files::Exists(path + "images") || Files::Exists(path + "sounds"))
+		if(AssetManifest::Exists(path + "data") || AssetManifest::Exists(path + "images") || AssetManifest::Exists(path + "sounds"))
 			sources.push_back(path);
 	}
 	
-	vector<string> localPlugins = Files::ListDirectories(Files::Config() + "plugins/");
+	vector<string> localPlugins = AssetManifest::ListDirectories(Files::Config() + "plugins/");
 	for(const string &path : localPlugins)
 	{
-		if(Files::Exists(path + "data") || Files::Exists(path + "images") || Files::Exists(path + "sounds"))
+		if(AssetManifest::Exists(path + "data") || AssetManifest::Exists(path + "images") || AssetManifest::Exists(path + "sounds"))
 			sources.push_back(path);
 	}
 }
 
 
 
-void GameData::LoadFile(const string &path, bool debugMode)
+void GameData::LoadFile(const DataFile &data)
 {
-	// This is an ordinary file. Check to see if it is an image.
-	if(path.length() < 4 || path.compare(path.length() - 4, 4, ".txt"))
-		return;
-	
-	DataFile data(path);
-	if(debugMode)
-		Files::LogError("Parsing: " + path);
-	
 	for(const DataNode &node : data)
+		LoadNode(node);
+}
+
+
+
+void GameData::LoadNode(const DataNode &node)
+{
+	const string &key = node.Token(0);
+	if(key == "color" && node.Size() >= 6)
+		colors.Define(node.Token(1))->Load(
+			node.Value(2), node.Value(3), node.Value(4), node.Value(5));
+	else if(key == "conversation" && node.Size() >= 2)
+		conversations.Define(node.Token(1))->Load(node);
+	else if(key == "effect" && node.Size() >= 2)
+		effects.Define(node.Token(1))->Load(node);
+	else if(key == "event" && node.Size() >= 2)
+		events.Define(node.Token(1))->Load(node);
+	else if(key == "fleet" && node.Size() >= 2)
+		fleets.Define(node.Token(1))->Load(node);
+	else if(key == "galaxy" && node.Size() >= 2)
+		galaxies.Define(node.Token(1))->Load(node);
+	else if(key == "government" && node.Size() >= 2)
+		governments.Define(node.Token(1))->Load(node);
+	else if(key == "interface" && node.Size() >= 2)
+		interfaces.Define(node.Token(1))->Load(node);
+	else if(key == "mission" && node.Size() >= 2)
+		missions.Define(node.Token(1))->Load(node);
+	else if(key == "outfit" && node.Size() >= 2)
+		outfits.Define(node.Token(1))->Load(node);
+	else if(key == "outfitter" && node.Size() >= 2)
+		outfitSales.Define(node.Token(1))->Load(node, outfits);
+	else if(key == "person" && node.Size() >= 2)
+		persons.Define(node.Token(1))->Load(node);
+	else if(key == "phrase" && node.Size() >= 2)
+		phrases.Define(node.Token(1))->Load(node);
+	else if(key == "planet" && node.Size() >= 2)
+		planets.Define(node.Token(1))->Load(node, shipSales, outfitSales);
+	else if(key == "ship" && node.Size() >= 2)
 	{
-		const string &key = node.Token(0);
-		if(key == "color" && node.Size() >= 6)
-			colors.Get(node.Token(1))->Load(
-				node.Value(2), node.Value(3), node.Value(4), node.Value(5));
-		else if(key == "conversation" && node.Size() >= 2)
-			conversations.Get(node.Token(1))->Load(node);
-		else if(key == "effect" && node.Size() >= 2)
-			effects.Get(node.Token(1))->Load(node);
-		else if(key == "event" && node.Size() >= 2)
-			events.Get(node.Token(1))->Load(node);
-		else if(key == "fleet" && node.Size() >= 2)
-			fleets.Get(node.Token(1))->Load(node);
-		else if(key == "galaxy" && node.Size() >= 2)
-			galaxies.Get(node.Token(1))->Load(node);
-		else if(key == "government" && node.Size() >= 2)
-			governments.Get(node.Token(1))->Load(node);
-		else if(key == "interface" && node.Size() >= 2)
-			interfaces.Get(node.Token(1))->Load(node);
-		else if(key == "mission" && node.Size() >= 2)
-			missions.Get(node.Token(1))->Load(node);
-		else if(key == "outfit" && node.Size() >= 2)
-			outfits.Get(node.Token(1))->Load(node);
-		else if(key == "outfitter" && node.Size() >= 2)
-			outfitSales.Get(node.Token(1))->Load(node, outfits);
-		else if(key == "person" && node.Size() >= 2)
-			persons.Get(node.Token(1))->Load(node);
-		else if(key == "phrase" && node.Size() >= 2)
-			phrases.Get(node.Token(1))->Load(node);
-		else if(key == "planet" && node.Size() >= 2)
-			planets.Get(node.Token(1))->Load(node, shipSales, outfitSales);
-		else if(key == "ship" && node.Size() >= 2)
-		{
-			// Allow multiple named variants of the same ship model.
-			const string &name = node.Token((node.Size() > 2) ? 2 : 1);
-			ships.Get(name)->Load(node);
-		}
-		else if(key == "shipyard" && node.Size() >= 2)
-			shipSales.Get(node.Token(1))->Load(node, ships);
-		else if(key == "start")
-			startConditions.Load(node);
-		else if(key == "system" && node.Size() >= 2)
-			systems.Get(node.Token(1))->Load(node, planets);
-		else if(key == "trade")
-			trade.Load(node);
-		else
-			node.PrintTrace("Skipping unrecognized root object:");
+		// Allow multiple named variants of the same ship model.
+		const string &name = node.Token((node.Size() > 2) ? 2 : 1);
+		ships.Define(name)->Load(node);
 	}
+	else if(key == "shipyard" && node.Size() >= 2)
+		shipSales.Define(node.Token(1))->Load(node, ships);
+	else if(key == "start")
+		startConditions.Load(node);
+	else if(key == "system" && node.Size() >= 2)
+		systems.Define(node.Token(1))->Load(node, planets);
+	else if(key == "trade")
+		trade.Load(node);
+	else
+		node.PrintTrace("Skipping unrecognized root object:");
 }
 
 
@@ -682,22 +1167,34 @@ void GameData::LoadImages(map<string, string> &images)
 	for(const string &source : sources)
 	{
 		string directoryPath = source + "images/";
-		vector<string> imageFiles = Files::RecursiveList(directoryPath);
+		string cookedPath = source + "cooked/";
+		vector<string> imageFiles;
+		{
+			StartupProfile::Phase phase("list image files", directoryPath);
+			imageFiles = AssetManifest::RecursiveList(directoryPath);
+		}
 		for(const string &path : imageFiles)
-			LoadImage(path, images, directoryPath.length());
+			LoadImage(path, images, directoryPath.length(), cookedPath);
 	}
 }
 
 
 
-void GameData::LoadImage(const string &path, map<string, string> &images, size_t start)
+void GameData::LoadImage(const string &path, map<string, string> &images, size_t start, const string &cookedPath)
 {
 	bool isJpg = !path.compare(path.length() - 4, 4, ".jpg");
 	bool isPng = !path.compare(path.length() - 4, 4, ".png");
 	
 	// This is an ordinary file. Check to see if it is an image.
-	if(isJpg || isPng)
-		images[path.substr(start)] = path;
+	if(!isJpg && !isPng)
+		return;
+	
+	// If this image has been cooked, and has not been changed since then, load
+	// the cooked version instead.
+	string name = path.substr(start);
+	string cooked = cookedPath + name + ".tex";
+	time_t timestamp = AssetManifest::Exists(cooked) ? Files::Timestamp(cooked) : 0;
+	images[name] = (timestamp && timestamp >= Files::Timestamp(path)) ? cooked : path;
 }
 
 
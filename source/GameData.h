@@ -22,6 +22,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 class Color;
 class Conversation;
+class DataFile;
 class DataNode;
 class DataWriter;
 class Date;
@@ -36,6 +37,7 @@ class Outfit;
 class Person;
 class Phrase;
 class Planet;
+class PlayerInfo;
 class Politics;
 class Ship;
 class Sprite;
@@ -56,10 +58,34 @@ public:
 	static void BeginLoad(const char * const *argv);
 	static void LoadShaders();
 	static double Progress();
-	// Begin loading a sprite that was previously deferred. Currently this is
-	// done with all landscapes to speed up the program's startup.
-	static void Preload(const Sprite *sprite);
+	// Load a sprite that is likely to be drawn soon (e.g. a landscape), rather
+	// than waiting until it is drawn. If the sprite is needed right away, it is
+	// loaded ahead of everything else.
+	static void Preload(const Sprite *sprite, bool isUrgent = false);
+	// Load the sprites that the given player will see first before anything
+	// else: their current system, and then their ships.
+	static void Prioritize(const PlayerInfo &player);
+	// If BeginLoad() skipped the @2x images but Screen::IsHighResolution() has
+	// since become true (because this is a high DPI display, or because the
+	// zoom is above 100%), load them. Call this whenever that may change. They
+	// are added the next time StepSprites() is called.
+	static void LoadHighDPI();
 	static void FinishLoading();
+	// Load any sprites that were drawn before they were loaded, and unload
+	// the least recently used ones if they take up too much memory. This must
+	// be called once per frame, and only when the game's calculation thread is
+	// not running, because it changes sprites that the game may be drawing.
+	static void StepSprites();
+	// Print how many sprites are loaded, and how much memory they use.
+	static void PrintSpriteReport();
+	// In debug mode, reload any data files or images that have been changed
+	// since the last time this was called. Objects that are already defined
+	// are changed in place: every definition of each changed object, from any
+	// file, is applied again in the order that the files were first loaded.
+	// This must only be called when the game's calculation thread is not running.
+	static void ReloadChanges();
+	// Check whether the game was started with the "--debug" flag.
+	static bool DebugMode();
 	
 	// Get the list of resource sources (i.e. plugin folders).
 	static const std::vector<std::string> &Sources();
@@ -100,12 +126,21 @@ public:
 	
 	static const StarField &Background();
 	
+	// Report anything that was looked up by name but never defined.
+	static void CheckReferences();
+	
+	// Convert every image into a cooked texture (premultiplied, mipmapped and
+	// optionally block compressed) in the "cooked" folder next to it. Images
+	// whose cooked version is already up to date are skipped.
+	static void CookImages(const char * const *argv, bool compress);
+	
 	
 private:
 	static void LoadSources();
-	static void LoadFile(const std::string &path, bool debugMode);
+	static void LoadFile(const DataFile &data);
+	static void LoadNode(const DataNode &node);
 	static void LoadImages(std::map<std::string, std::string> &images);
-	static void LoadImage(const std::string &path, std::map<std::string, std::string> &images, size_t start);
+	static void LoadImage(const std::string &path, std::map<std::string, std::string> &images, size_t start, const std::string &cookedPath);
 	static std::string Name(const std::string &path);
 	
 	static void PrintShipTable();
@@ -193,20 +193,29 @@ void HailPanel::Draw() const
 	
 	// Draw the sprite, rotated, scaled, and swizzled as necessary.
 	int swizzle = ship ? ship->GetGovernment()->GetSwizzle() : 0;
-	uint32_t tex = sprite->Texture();
-	
-	float pos[2] = {-170.f, -10.f};
+	const Sprite::Region &region = sprite->GetRegion();
 	
 	double zoom = min(1., 200. / max(sprite->Width(), sprite->Height()));
 	Point uw = unit * (sprite->Width() * zoom);
 	Point uh = unit * (sprite->Height() * zoom);
-	float tr[4] = {
-		static_cast<float>(-uw.Y()), static_cast<float>(uw.X()),
-		static_cast<float>(-uh.X()), static_cast<float>(-uh.Y())};
+	SpriteShader::Instance instance = {
+		{-170.f, -10.f},
+		{static_cast<float>(-uw.Y()), static_cast<float>(uw.X()),
+			static_cast<float>(-uh.X()), static_cast<float>(-uh.Y())},
+		{0.f, 0.f},
+		1.f,
+		0.f,
+		static_cast<float>(swizzle),
+		{region.rect[0], region.rect[1], region.rect[2], region.rect[3]},
+		{0.f, 0.f, 1.f, 1.f}
+	};
 	
-	SpriteShader::Bind();
-	SpriteShader::Add(tex, tex, pos, tr, swizzle);
-	SpriteShader::Unbind();
+	if(region.texture)
+	{
+		SpriteShader::Bind();
+		SpriteShader::Add(region.texture, 0, &instance, 1);
+		SpriteShader::Unbind();
+	}
 	
 	// Draw the current message.
 	WrappedText wrap;
@@ -0,0 +1,40 @@
+/* Handle.h
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef HANDLE_H_
+#define HANDLE_H_
+
+
+
+// A reference to a named object (e.g. in a Set or the SpriteSet) that has
+// already been looked up. Named objects never move once they are created, so
+// a handle can be resolved once and then kept in a member or static variable
+// instead of repeating the lookup every frame.
+template<class Type>
+class Handle {
+public:
+	Handle() = default;
+	explicit Handle(const Type *object) : object(object) {}
+	
+	const Type *Get() const { return object; }
+	const Type *operator->() const { return object; }
+	const Type &operator*() const { return *object; }
+	explicit operator bool() const { return object; }
+	
+	
+private:
+	const Type *object = nullptr;
+};
+
+
+
+#endif
@@ -13,6 +13,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef IMAGE_BUFFER_H_
 #define IMAGE_BUFFER_H_
 
+#include <cstdint>
 #include <string>
 
 
@@ -41,7 +42,26 @@ public:
 	const uint32_t *Begin(int y) const;
 	uint32_t *Begin(int y);
 	
-	static ImageBuffer *Read(const std::string &path);
+	// Shrink this image to half its size (rounding down), averaging each 2x2
+	// block of pixels. This should only be done once the image has been
+	// premultiplied.
+	void ShrinkToHalfSize();
+	
+	// Read the image at the given path. If halfSize is set, the image is read at
+	// half its normal size, e.g. so that an @2x image can stand in for a missing
+	// @1x image. JPEG images are scaled as they are decoded, which is faster
+	// than decoding them at full size.
+	static ImageBuffer *Read(const std::string &path, bool halfSize = false);
+	// Read only the dimensions of the image at the given path, which is much
+	// faster than decoding it. This returns false if the file is not valid.
+	static bool ReadSize(const std::string &path, int &width, int &height);
+	
+	// Convert one row of pixels to premultiplied alpha. "Additive" is 0 for a
+	// normal image, 1 for a half-additive (~) one, and 2 for an additive (+)
+	// one. The vector version, if the compiler targets SSE2 or AVX2, must give
+	// exactly the same results as the scalar one.
+	static void PremultiplyRow(uint32_t *it, uint32_t *end, int additive);
+	static void PremultiplyRowScalar(uint32_t *it, uint32_t *end, int additive);
 	
 	
 private:
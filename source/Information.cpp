@@ -14,84 +14,206 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Sprite.h"
 
+#include <map>
+#include <mutex>
+
 using namespace std;
 
+namespace {
+	// Slots are shared by every Information object. They may be assigned while
+	// the game data is being loaded in another thread.
+	mutex slotMutex;
+	map<string, int> &Slots()
+	{
+		static map<string, int> slots;
+		return slots;
+	}
+	
+	const Sprite *EmptySprite()
+	{
+		static const Sprite empty;
+		return &empty;
+	}
+	
+	const Point UP(0., -1.);
+	const string EMPTY;
+	
+	// Check if the given slot has been filled in.
+	template <class Type>
+	bool Has(const vector<Type> &values, int slot)
+	{
+		return static_cast<unsigned>(slot) < values.size();
+	}
+	
+	// Make sure the given slot exists, filling in any new slots with the
+	// default value, and return it.
+	template <class Type, class Value>
+	typename vector<Type>::reference At(vector<Type> &values, int slot, const Value &defaultValue)
+	{
+		if(!Has(values, slot))
+			values.resize(slot + 1, defaultValue);
+		return values[slot];
+	}
+}
+
+
+
+// Get the slot for the given name, assigning a new one if necessary.
+int Information::Slot(const string &name)
+{
+	lock_guard<mutex> lock(slotMutex);
+	
+	map<string, int> &slots = Slots();
+	auto it = slots.find(name);
+	if(it != slots.end())
+		return it->second;
+	
+	int slot = slots.size();
+	slots[name] = slot;
+	return slot;
+}
+
+
+
+void Information::SetSprite(int slot, const Sprite *sprite, const Point &unit)
+{
+	if(slot < 0)
+		return;
+	
+	At(sprites, slot, EmptySprite()) = sprite;
+	At(spriteUnits, slot, UP) = unit;
+}
+
 
 
 void Information::SetSprite(const string &name, const Sprite *sprite, const Point &unit)
 {
-	sprites[name] = sprite;
-	spriteUnits[name] = unit;
+	SetSprite(Slot(name), sprite, unit);
+}
+
+
+
+const Sprite *Information::GetSprite(int slot) const
+{
+	return Has(sprites, slot) ? sprites[slot] : EmptySprite();
 }
 
 
 
 const Sprite *Information::GetSprite(const string &name) const
 {
-	static const Sprite empty;
-	
-	auto it = sprites.find(name);
-	return (it == sprites.end()) ? &empty : it->second;
+	return GetSprite(Slot(name));
+}
+
+
+
+const Point &Information::GetSpriteUnit(int slot) const
+{
+	return Has(spriteUnits, slot) ? spriteUnits[slot] : UP;
 }
 
 
 
 const Point &Information::GetSpriteUnit(const string &name) const
 {
-	static const Point up(0., -1.);
-	
-	auto it = spriteUnits.find(name);
-	return (it == spriteUnits.end()) ? up : it->second;
+	return GetSpriteUnit(Slot(name));
+}
+
+
+
+void Information::SetString(int slot, const string &value)
+{
+	if(slot >= 0)
+		At(strings, slot, string()) = value;
 }
 
 
 
 void Information::SetString(const string &name, const string &value)
 {
-	strings[name] = value;
+	SetString(Slot(name), value);
+}
+
+
+
+const string &Information::GetString(int slot) const
+{
+	return Has(strings, slot) ? strings[slot] : EMPTY;
 }
 
 
 
 const string &Information::GetString(const string &name) const
 {
-	static const string empty;
+	return GetString(Slot(name));
+}
+
+
+
+void Information::SetBar(int slot, double value, double segments)
+{
+	if(slot < 0)
+		return;
 	
-	auto it = strings.find(name);
-	return (it == strings.end()) ? empty : it->second;
+	At(bars, slot, 1.) = value;
+	At(barSegments, slot, 1.) = segments;
 }
 
 
 
 void Information::SetBar(const string &name, double value, double segments)
 {
-	bars[name] = value;
-	barSegments[name] = static_cast<double>(segments);
+	SetBar(Slot(name), value, segments);
+}
+
+
+
+double Information::BarValue(int slot) const
+{
+	return Has(bars, slot) ? bars[slot] : 1.;
 }
 
 
 
 double Information::BarValue(const string &name) const
 {
-	auto it = bars.find(name);
-	
-	return (it == bars.end()) ? 1. : it->second;
+	return BarValue(Slot(name));
+}
+
+
+
+double Information::BarSegments(int slot) const
+{
+	return Has(barSegments, slot) ? barSegments[slot] : 1.;
 }
 
 
 
 double Information::BarSegments(const string &name) const
 {
-	auto it = barSegments.find(name);
-	
-	return (it == barSegments.end()) ? 1. : it->second;
+	return BarSegments(Slot(name));
 }
 
 
 	
+void Information::SetCondition(int slot)
+{
+	if(slot >= 0)
+		At(conditions, slot, false) = true;
+}
+
+
+
 void Information::SetCondition(const string &condition)
 {
-	conditions.insert(condition);
+	SetCondition(Slot(condition));
+}
+
+
+
+bool Information::HasCondition(int slot) const
+{
+	return Has(conditions, slot) && conditions[slot];
 }
 
 
@@ -104,7 +226,7 @@ bool Information::HasCondition(const string &condition) const
 	if(condition.front() == '!')
 		return !HasCondition(condition.substr(1));
 	
-	return conditions.count(condition);
+	return HasCondition(Slot(condition));
 }
 
 
@@ -16,30 +16,44 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Color.h"
 #include "Point.h"
 
-#include <map>
-#include <set>
 #include <string>
+#include <vector>
 
 class Sprite;
 
 
 
 // Class representing information to be displayed in a user interface, independent
-// of how that information is laid out or shown.
+// of how that information is laid out or shown. Each named item is stored in a
+// numbered slot; interfaces look up the slot numbers once, when they are
+// loaded, so drawing them does not require any string comparisons.
 class Information {
 public:
+	// Get the slot for the given name, assigning a new one if necessary.
+	static int Slot(const std::string &name);
+	
+	void SetSprite(int slot, const Sprite *sprite, const Point &unit = Point(0., -1.));
 	void SetSprite(const std::string &name, const Sprite *sprite, const Point &unit = Point(0., -1.));
+	const Sprite *GetSprite(int slot) const;
 	const Sprite *GetSprite(const std::string &name) const;
+	const Point &GetSpriteUnit(int slot) const;
 	const Point &GetSpriteUnit(const std::string &name) const;
 	
+	void SetString(int slot, const std::string &value);
 	void SetString(const std::string &name, const std::string &value);
+	const std::string &GetString(int slot) const;
 	const std::string &GetString(const std::string &name) const;
 	
+	void SetBar(int slot, double value, double segments = 0.);
 	void SetBar(const std::string &name, double value, double segments = 0.);
+	double BarValue(int slot) const;
 	double BarValue(const std::string &name) const;
+	double BarSegments(int slot) const;
 	double BarSegments(const std::string &name) const;
 	
+	void SetCondition(int slot);
 	void SetCondition(const std::string &condition);
+	bool HasCondition(int slot) const;
 	bool HasCondition(const std::string &condition) const;
 	
 	void SetOutlineColor(const Color &color);
@@ -47,13 +61,13 @@ public:
 	
 	
 private:
-	std::map<std::string, const Sprite *> sprites;
-	std::map<std::string, Point> spriteUnits;
-	std::map<std::string, std::string> strings;
-	std::map<std::string, double> bars;
-	std::map<std::string, double> barSegments;
+	std::vector<const Sprite *> sprites;
+	std::vector<Point> spriteUnits;
+	std::vector<std::string> strings;
+	std::vector<double> bars;
+	std::vector<double> barSegments;
 	
-	std::set<std::string> conditions;
+	std::vector<bool> conditions;
 	
 	Color outlineColor;
 };
@@ -86,7 +86,7 @@ void Interface::Load(const DataNode &node)
 					grand.PrintTrace("Skipping unrecognized attribute:");
 			}
 			
-			vec.back().condition = condition;
+			vec.back().condition = Condition(condition);
 		}
 		else if((key == "label" || key == "string") && child.Size() >= 4)
 		{
@@ -94,6 +94,8 @@ void Interface::Load(const DataNode &node)
 			
 			Point position(child.Value(2), child.Value(3));
 			vec.emplace_back(child.Token(1), position);
+			if(key == "string")
+				vec.back().slot = Information::Slot(child.Token(1));
 			
 			for(const DataNode &grand : child)
 			{
@@ -110,7 +112,7 @@ void Interface::Load(const DataNode &node)
 					grand.PrintTrace("Skipping unrecognized attribute:");
 			}
 			
-			vec.back().condition = condition;
+			vec.back().condition = Condition(condition);
 		}
 		else if((key == "bar" || key == "ring") && child.Size() >= 4)
 		{
@@ -133,7 +135,7 @@ void Interface::Load(const DataNode &node)
 					grand.PrintTrace("Skipping unrecognized attribute:");
 			}
 			
-			vec.back().condition = condition;
+			vec.back().condition = Condition(condition);
 		}
 		else if(key == "button" && child.Size() >= 4)
 		{
@@ -176,12 +178,12 @@ void Interface::Draw(const Information &info, const Point &offset) const
 	
 	for(const SpriteSpec &sprite : sprites)
 	{
-		if(!info.HasCondition(sprite.condition))
+		if(!sprite.condition.Matches(info))
 			continue;
 		
 		const Sprite *s = sprite.sprite;
 		if(!s)
-			s = info.GetSprite(sprite.name);
+			s = info.GetSprite(sprite.slot);
 		if(!s)
 			continue;
 		
@@ -197,12 +199,12 @@ void Interface::Draw(const Information &info, const Point &offset) const
 	}
 	for(const SpriteSpec &outline : outlines)
 	{
-		if(!info.HasCondition(outline.condition))
+		if(!outline.condition.Matches(info))
 			continue;
 		
 		const Sprite *s = outline.sprite;
 		if(!s)
-			s = info.GetSprite(outline.name);
+			s = info.GetSprite(outline.slot);
 		if(!s)
 			continue;
 		
@@ -213,13 +215,13 @@ void Interface::Draw(const Information &info, const Point &offset) const
 		Point pos = outline.position + corner - outline.size * position;
 		OutlineShader::Draw(s, pos, size,
 			outline.isColored ? info.GetOutlineColor() : Color(1., 1.),
-			info.GetSpriteUnit(outline.name));
+			info.GetSpriteUnit(outline.slot));
 	}
 	
 	double defaultAlign = position.X() + .5;
 	for(const StringSpec &spec : labels)
 	{
-		if(!info.HasCondition(spec.condition))
+		if(!spec.condition.Matches(info))
 			continue;
 		
 		const string &str = spec.str;
@@ -231,10 +233,10 @@ void Interface::Draw(const Information &info, const Point &offset) const
 	}
 	for(const StringSpec &spec : strings)
 	{
-		if(!info.HasCondition(spec.condition))
+		if(!spec.condition.Matches(info))
 			continue;
 		
-		const string &str = info.GetString(spec.str);
+		const string &str = info.GetString(spec.slot);
 		
 		const Font &font = FontSet::Get(spec.size);
 		double a = (spec.align >= 0.) ? spec.align : defaultAlign;
@@ -242,17 +244,18 @@ void Interface::Draw(const Information &info, const Point &offset) const
 		font.Draw(str, corner - align + spec.position, spec.color);
 	}
 	
+	LineShader::Bind();
 	for(const BarSpec &spec : bars)
 	{
-		if(!info.HasCondition(spec.condition))
+		if(!spec.condition.Matches(info))
 			continue;
 		
 		double length = spec.size.Length();
 		if(!length || !spec.width)
 			continue;
 		
-		double value = info.BarValue(spec.name);
-		double segments = info.BarSegments(spec.name);
+		double value = info.BarValue(spec.slot);
+		double segments = info.BarSegments(spec.slot);
 		if(!value)
 			continue;
 		
@@ -269,27 +272,31 @@ void Interface::Draw(const Information &info, const Point &offset) const
 			Point to = start + min(v, value) * spec.size;
 			v += empty;
 			
-			LineShader::Draw(from, to, spec.width, spec.color);
+			LineShader::Add(from, to, spec.width, spec.color);
 		}
 	}
+	LineShader::Unbind();
+	
+	RingShader::Bind();
 	for(const BarSpec &spec : rings)
 	{
-		if(!info.HasCondition(spec.condition))
+		if(!spec.condition.Matches(info))
 			continue;
 		
 		if(!spec.size.X() || !spec.size.Y() || !spec.width)
 			continue;
 		
-		double value = info.BarValue(spec.name);
-		double segments = info.BarSegments(spec.name);
+		double value = info.BarValue(spec.slot);
+		double segments = info.BarSegments(spec.slot);
 		if(!value)
 			continue;
 		if(segments <= 1.)
 			segments = 0.;
 		
 		Point center = spec.position + corner - spec.size * position;
-		RingShader::Draw(center, .5 * spec.size.X(), spec.width, value, spec.color, segments);
+		RingShader::Add(center, .5 * spec.size.X(), spec.width, value, spec.color, segments);
 	}
+	RingShader::Unbind();
 }
 
 
@@ -338,29 +345,56 @@ Point Interface::GetSize(const string &name) const
 
 
 
+Interface::Condition::Condition()
+	: slot(-1), isNegated(false)
+{
+}
+
+
+
+Interface::Condition::Condition(const string &name)
+	: Condition()
+{
+	if(name.empty())
+		return;
+	
+	isNegated = (name.front() == '!');
+	slot = Information::Slot(isNegated ? name.substr(1) : name);
+}
+
+
+
+// An empty condition always matches.
+bool Interface::Condition::Matches(const Information &info) const
+{
+	return slot < 0 || info.HasCondition(slot) != isNegated;
+}
+
+
+
 Interface::SpriteSpec::SpriteSpec(const string &str, const Point &position)
-	: name(str), sprite(nullptr), position(position), isColored(false)
+	: slot(Information::Slot(str)), sprite(nullptr), position(position), isColored(false)
 {
 }
 
 
 
 Interface::SpriteSpec::SpriteSpec(const Sprite *sprite, const Point &position)
-	: sprite(sprite), position(position), isColored(false)
+	: slot(-1), sprite(sprite), position(position), isColored(false)
 {
 }
 
 
 
 Interface::StringSpec::StringSpec(const string &str, const Point &position)
-	: str(str), position(position), align(-1.), size(14)
+	: str(str), slot(-1), position(position), align(-1.), size(14)
 {
 }
 
 
 
 Interface::BarSpec::BarSpec(const string &name, const Point &position)
-	: name(name), position(position), width(0.0)
+	: slot(Information::Slot(name)), position(position), width(0.0)
 {
 }
 
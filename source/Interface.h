@@ -27,7 +27,8 @@ class Sprite;
 
 
 // Class representing a user interface, specified in a data file and filled with
-// the contents of an Information object.
+// the contents of an Information object. All the names of the elements to be
+// filled in are resolved to Information slots when the interface is loaded.
 class Interface {
 public:
 	void Load(const DataNode &node);
@@ -42,44 +43,60 @@ public:
 	
 	
 private:
+	// A condition that must hold for an element to be drawn, possibly negated
+	// (i.e. "!name" means the named condition must not be set).
+	class Condition {
+	public:
+		Condition();
+		Condition(const std::string &name);
+		
+		bool Matches(const Information &info) const;
+		
+	private:
+		int slot;
+		bool isNegated;
+	};
+	
 	class SpriteSpec {
 	public:
 		SpriteSpec(const std::string &str, const Point &position);
 		SpriteSpec(const Sprite *sprite, const Point &position);
 		
-		std::string name;
+		int slot;
 		const Sprite *sprite;
 		Point position;
 		Point size;
 		bool isColored;
 		
-		std::string condition;
+		Condition condition;
 	};
 	
 	class StringSpec {
 	public:
 		StringSpec(const std::string &str, const Point &position);
 		
+		// Labels are literal text; strings are filled in from a slot.
 		std::string str;
+		int slot;
 		Point position;
 		double align;
 		int size;
 		Color color;
 		
-		std::string condition;
+		Condition condition;
 	};
 	
 	class BarSpec {
 	public:
 		BarSpec(const std::string &name, const Point &position);
 		
-		std::string name;
+		int slot;
 		Point position;
 		Point size;
 		Color color;
 		float width;
 		
-		std::string condition;
+		Condition condition;
 	};
 	
 	class ButtonSpec {
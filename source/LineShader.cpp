@@ -17,20 +17,36 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Screen.h"
 #include "Shader.h"
 
+#include <initializer_list>
 #include <stdexcept>
+#include <vector>
 
 using namespace std;
 
 namespace {
 	Shader shader;
 	GLint scaleI;
-	GLint startI;
-	GLint lengthI;
-	GLint widthI;
-	GLint colorI;
 	
 	GLuint vao;
 	GLuint vbo;
+	
+	// Each line is drawn as two triangles. Every vertex carries a copy of the
+	// line's parameters, so that any number of lines can be drawn at once.
+	const int STRIDE = 12;
+	const float CORNERS[6][2] = {
+		{0.f, -1.f}, {1.f, -1.f}, {0.f, 1.f},
+		{1.f, -1.f}, {1.f, 1.f}, {0.f, 1.f}
+	};
+	// Lines added since the last call to Bind().
+	vector<GLfloat> vertices;
+	
+	void EnableAttrib(const char *name, int size, int offset)
+	{
+		GLuint attrib = shader.Attrib(name);
+		glEnableVertexAttribArray(attrib);
+		glVertexAttribPointer(attrib, size, GL_FLOAT, GL_FALSE,
+			STRIDE * sizeof(GLfloat), reinterpret_cast<const GLvoid *>(offset * sizeof(GLfloat)));
+	}
 }
 
 
@@ -39,38 +55,37 @@ void LineShader::Init()
 {
 	static const char *vertexCode =
 		"uniform vec2 scale;\n"
-		"uniform vec2 start;\n"
-		"uniform vec2 len;\n"
-		"uniform vec2 width;\n"
 		
 		"in vec2 vert;\n"
+		"in vec2 start;\n"
+		"in vec2 len;\n"
+		"in vec2 width;\n"
+		"in vec4 color;\n"
+		
 		"out vec2 tpos;\n"
 		"out float tscale;\n"
+		"out vec4 lineColor;\n"
 		
 		"void main() {\n"
 		"  tpos = vert;\n"
 		"  tscale = length(len);\n"
+		"  lineColor = color;\n"
 		"  gl_Position = vec4((start + vert.x * len + vert.y * width) * scale, 0, 1);\n"
 		"}\n";
 
 	static const char *fragmentCode =
-		"uniform vec4 color = vec4(1, 1, 1, 1);\n"
-		
 		"in vec2 tpos;\n"
 		"in float tscale;\n"
+		"in vec4 lineColor;\n"
 		"out vec4 finalColor;\n"
 		
 		"void main() {\n"
 		"  float alpha = min(tscale - abs(tpos.x * (2 * tscale) - tscale), 1 - abs(tpos.y));\n"
-		"  finalColor = color * alpha;\n"
+		"  finalColor = lineColor * alpha;\n"
 		"}\n";
 	
 	shader = Shader(vertexCode, fragmentCode);
 	scaleI = shader.Uniform("scale");
-	startI = shader.Uniform("start");
-	lengthI = shader.Uniform("len");
-	widthI = shader.Uniform("width");
-	colorI = shader.Uniform("color");
 	
 	// Generate the vertex data for drawing sprites.
 	glGenVertexArrays(1, &vao);
@@ -79,17 +94,11 @@ void LineShader::Init()
 	glGenBuffers(1, &vbo);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	
-	GLfloat vertexData[] = {
-		0.f, -1.f,
-		1.f, -1.f,
-		0.f,  1.f,
-		1.f,  1.f
-	};
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertexData), vertexData, GL_STATIC_DRAW);
-	
-	glEnableVertexAttribArray(shader.Attrib("vert"));
-	glVertexAttribPointer(shader.Attrib("vert"), 2, GL_FLOAT, GL_FALSE,
-		2 * sizeof(GLfloat), NULL);
+	EnableAttrib("vert", 2, 0);
+	EnableAttrib("start", 2, 2);
+	EnableAttrib("len", 2, 4);
+	EnableAttrib("width", 2, 6);
+	EnableAttrib("color", 4, 8);
 	
 	// unbind the VBO and VAO
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -100,29 +109,62 @@ void LineShader::Init()
 
 void LineShader::Draw(const Point &from, const Point &to, float width, const Color &color)
 {
-	if(!shader.Object())
-		throw runtime_error("LineShader: Draw() called before Init().");
+	Bind();
 	
-	glUseProgram(shader.Object());
-	glBindVertexArray(vao);
-	
-	GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
-	glUniform2fv(scaleI, 1, scale);
+	Add(from, to, width, color);
 	
-	GLfloat start[2] = {static_cast<float>(from.X()), static_cast<float>(from.Y())};
-	glUniform2fv(startI, 1, start);
+	Unbind();
+}
+
+
+
+void LineShader::Bind()
+{
+	if(!shader.Object())
+		throw runtime_error("LineShader: Bind() called before Init().");
 	
+	vertices.clear();
+}
+
+
+
+void LineShader::Add(const Point &from, const Point &to, float width, const Color &color)
+{
 	Point v = to - from;
 	Point u = v.Unit() * width;
-	GLfloat length[2] = {static_cast<float>(v.X()), static_cast<float>(v.Y())};
-	glUniform2fv(lengthI, 1, length);
-	
-	GLfloat w[2] = {static_cast<float>(u.Y()), static_cast<float>(-u.X())};
-	glUniform2fv(widthI, 1, w);
+	float x = from.X();
+	float y = from.Y();
+	float vx = v.X();
+	float vy = v.Y();
+	float wx = u.Y();
+	float wy = -u.X();
+	const float *c = color.Get();
 	
-	glUniform4fv(colorI, 1, color.Get());
-	
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	for(const float *corner : CORNERS)
+		vertices.insert(vertices.end(), {corner[0], corner[1], x, y, vx, vy,
+			wx, wy, c[0], c[1], c[2], c[3]});
+}
+
+
+
+// Draw all the lines that were added since Bind() with a single draw call.
+void LineShader::Unbind()
+{
+	if(!vertices.empty())
+	{
+		glUseProgram(shader.Object());
+		glBindVertexArray(vao);
+		
+		GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
+		glUniform2fv(scaleI, 1, scale);
+		
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		
+		glDrawArrays(GL_TRIANGLES, 0, vertices.size() / STRIDE);
+		vertices.clear();
+	}
 	
 	glBindVertexArray(0);
 	glUseProgram(0);
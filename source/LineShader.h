@@ -19,12 +19,17 @@ class Point;
 
 
 // Class to be used for drawing lines. The sides of a line are anti-aliased, but
-// the start and end of the line are not.
+// the start and end of the line are not. To draw many lines at once, call Bind(),
+// then Add() each line, then Unbind(); they will all be drawn in one call.
 class LineShader {
 public:
 	static void Init();
 	
 	static void Draw(const Point &from, const Point &to, float width, const Color &color);
+	
+	static void Bind();
+	static void Add(const Point &from, const Point &to, float width, const Color &color);
+	static void Unbind();
 };
 
 
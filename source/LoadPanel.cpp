@@ -31,6 +31,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "ShipyardPanel.h"
 #include "StarField.h"
 #include "UI.h"
+#include "WriteQueue.h"
 
 #include <algorithm>
 
@@ -47,6 +48,9 @@ LoadPanel::LoadPanel(PlayerInfo &player, UI &gamePanels)
 	// game is paused, i.e. the "main panel" is not on top:
 	if(player.GetPlanet() && !player.IsDead() && !gamePanels.IsTop(&*gamePanels.Root()))
 		player.Save();
+	// Games are saved in the background. Make sure every file in the saves
+	// folder is complete before listing them.
+	WriteQueue::Wait();
 	UpdateLists();
 }
 
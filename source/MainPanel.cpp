@@ -51,6 +51,10 @@ MainPanel::MainPanel(PlayerInfo &player)
 void MainPanel::Step()
 {
 	engine.Wait();
+	// The engine's calculation thread is idle until Go() is called, so this is
+	// when it is safe to change the game data and the sprites.
+	GameData::ReloadChanges();
+	GameData::StepSprites();
 	
 	bool isActive = GetUI()->IsTop(this);
 	
@@ -523,6 +523,7 @@ void MapPanel::DrawTravelPlan() const
 	if(!playerSystem)
 		return;
 	const System *previous = playerSystem;
+	LineShader::Bind();
 	for(int i = player.TravelPlan().size() - 1; i >= 0; --i)
 	{
 		const System *next = player.TravelPlan()[i];
@@ -575,10 +576,11 @@ void MapPanel::DrawTravelPlan() const
 		else if(flagshipCapacity >= 0. || escortCapacity >= 0.)
 			drawColor = defaultColor;
 		
-		LineShader::Draw(from, to, 3., drawColor);
+		LineShader::Add(from, to, 3., drawColor);
 		
 		previous = next;
 	}
+	LineShader::Unbind();
 }
 
 
@@ -592,6 +594,7 @@ void MapPanel::DrawWormholes() const
 	const double wormholeArrowHeadRatio = .3;
 	
 	map<const System *, const System *> drawn;
+	LineShader::Bind();
 	for(const auto &it : GameData::Systems())
 	{
 		const System *previous = &it.second;
@@ -615,12 +618,13 @@ void MapPanel::DrawWormholes() const
 				
 				// Don't double-draw the links.
 				if(drawn[next] != previous)
-					LineShader::Draw(from, to, wormholeWidth, wormholeDimColor);
-				LineShader::Draw(from - wormholeUnit + arrowLeft, from - wormholeUnit, wormholeWidth, wormholeColor);
-				LineShader::Draw(from - wormholeUnit + arrowRight, from - wormholeUnit, wormholeWidth, wormholeColor);
-				LineShader::Draw(from, from - (wormholeUnit + Zoom() * 0.1 * unit), wormholeWidth, wormholeColor);
+					LineShader::Add(from, to, wormholeWidth, wormholeDimColor);
+				LineShader::Add(from - wormholeUnit + arrowLeft, from - wormholeUnit, wormholeWidth, wormholeColor);
+				LineShader::Add(from - wormholeUnit + arrowRight, from - wormholeUnit, wormholeWidth, wormholeColor);
+				LineShader::Add(from, from - (wormholeUnit + Zoom() * 0.1 * unit), wormholeWidth, wormholeColor);
 			}
 	}
+	LineShader::Unbind();
 }
 
 
@@ -630,6 +634,7 @@ void MapPanel::DrawLinks() const
 	// Draw the links between the systems.
 	Color closeColor(.6, .6);
 	Color farColor(.3, .3);
+	LineShader::Bind();
 	for(const auto &it : GameData::Systems())
 	{
 		const System *system = &it.second;
@@ -652,9 +657,10 @@ void MapPanel::DrawLinks() const
 				to += unit;
 				
 				bool isClose = (system == playerSystem || link == playerSystem);
-				LineShader::Draw(from, to, 1.2, isClose ? closeColor : farColor);
+				LineShader::Add(from, to, 1.2, isClose ? closeColor : farColor);
 			}
 	}
+	LineShader::Unbind();
 }
 
 
@@ -666,6 +672,7 @@ void MapPanel::DrawSystems() const
 	
 	// Draw the circles for the systems, colored based on the selected criterion,
 	// which may be government, services, or commodity prices.
+	RingShader::Bind();
 	for(const auto &it : GameData::Systems())
 	{
 		const System &system = it.second;
@@ -768,8 +775,9 @@ void MapPanel::DrawSystems() const
 			}
 		}
 		
-		RingShader::Draw(pos, OUTER, INNER, color);
+		RingShader::Add(pos, OUTER, INNER, color);
 	}
+	RingShader::Unbind();
 }
 
 
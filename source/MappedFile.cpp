@@ -0,0 +1,104 @@
+/* MappedFile.cpp
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "MappedFile.h"
+
+#include "Files.h"
+
+#if !defined _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <utility>
+
+using namespace std;
+
+
+
+MappedFile::MappedFile(const string &path)
+{
+#if !defined _WIN32
+	int fd = open(path.c_str(), O_RDONLY);
+	if(fd < 0)
+		return;
+	
+	struct stat buf;
+	if(!fstat(fd, &buf) && S_ISREG(buf.st_mode) && buf.st_size > 0)
+	{
+		void *view = mmap(nullptr, buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(view != MAP_FAILED)
+		{
+			data = static_cast<const char *>(view);
+			size = buf.st_size;
+			isMapped = true;
+		}
+	}
+	// The mapping remains valid after the file descriptor is closed.
+	close(fd);
+	if(isMapped)
+		return;
+#endif
+	
+	// Mapping is not possible; fall back to an ordinary read.
+	if(!Files::Exists(path))
+		return;
+	buffer = Files::Read(path);
+	data = buffer.data();
+	size = buffer.size();
+}
+
+
+
+MappedFile::MappedFile(MappedFile &&other)
+	: data(other.data), size(other.size), buffer(move(other.buffer)), isMapped(other.isMapped)
+{
+	// Moving the string may have moved its storage, too.
+	if(!isMapped)
+		data = buffer.data();
+	other.data = nullptr;
+	other.size = 0;
+	other.isMapped = false;
+}
+
+
+
+MappedFile::~MappedFile()
+{
+#if !defined _WIN32
+	if(isMapped)
+		munmap(const_cast<char *>(data), size);
+#endif
+}
+
+
+
+MappedFile::operator bool() const
+{
+	return data;
+}
+
+
+
+const char *MappedFile::Data() const
+{
+	return data;
+}
+
+
+
+size_t MappedFile::Size() const
+{
+	return size;
+}
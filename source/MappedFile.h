@@ -0,0 +1,49 @@
+/* MappedFile.h
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+
+
+// RAII wrapper for a read-only view of an entire file's contents. Where the
+// operating system supports it the file is memory-mapped, so reading from it
+// does not require copying the data into a separate buffer first. Otherwise,
+// the file is simply read into memory.
+class MappedFile {
+public:
+	MappedFile(const std::string &path);
+	MappedFile(const MappedFile &) = delete;
+	MappedFile(MappedFile &&other);
+	~MappedFile();
+	
+	MappedFile &operator=(const MappedFile &) = delete;
+	
+	operator bool() const;
+	
+	const char *Data() const;
+	size_t Size() const;
+	
+private:
+	const char *data = nullptr;
+	size_t size = 0;
+	// If the file could not be mapped, its contents are stored here instead.
+	std::string buffer;
+	bool isMapped = false;
+};
+
+
+
+#endif
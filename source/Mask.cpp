@@ -228,9 +228,15 @@ void Mask::Create(ImageBuffer *image)
 	
 	SmoothAndCenter(&raw, Point(image->Width(), image->Height()));
 	
-	Simplify(raw, &outline);
+	vector<Point> simplified;
+	Simplify(raw, &simplified);
+	radius = Radius(simplified);
 	
-	radius = Radius(outline);
+	// Masks are kept for as long as the game runs, so store the outline in a
+	// vector that is exactly the right size.
+	outline.clear();
+	outline.reserve(simplified.size());
+	outline.insert(outline.end(), simplified.begin(), simplified.end());
 }
 
 
@@ -299,8 +305,8 @@ bool Mask::WithinRange(Point point, Angle facing, double range) const
 	// For efficiency, compare to range^2 instead of range.
 	range *= range;
 	
-	for(const Point &p : outline)
-		if(p.DistanceSquared(point) < range)
+	for(const Vertex &p : outline)
+		if(p.Get().DistanceSquared(point) < range)
 			return true;
 	
 	return false;
@@ -318,8 +324,8 @@ double Mask::Range(Point point, Angle facing) const
 	if(Contains(point))
 		return 0.;
 	
-	for(const Point &p : outline)
-		range = min(range, p.Distance(point));
+	for(const Vertex &p : outline)
+		range = min(range, p.Get().Distance(point));
 	
 	return range;
 }
@@ -331,9 +337,10 @@ double Mask::Intersection(Point sA, Point vA) const
 	// Keep track of the closest intersection point found.
 	double closest = 1.;
 	
-	Point prev = outline.back();
-	for(const Point &next : outline)
+	Point prev = outline.back().Get();
+	for(const Vertex &vertex : outline)
 	{
+		Point next = vertex.Get();
 		// Check if there is an intersection. (If not, the cross would be 0.) If
 		// there is, handle it only if it is a point where the segment is
 		// entering the polygon rather than exiting it (i.e. cross > 0).
@@ -368,9 +375,10 @@ bool Mask::Contains(Point point) const
 	// For simplicity, use a ray pointing straight downwards. A segment then
 	// intersects only if its x coordinates span the point's coordinates.
 	int intersections = 0;
-	Point prev = outline.back();
-	for(const Point &next : outline)
+	Point prev = outline.back().Get();
+	for(const Vertex &vertex : outline)
 	{
+		Point next = vertex.Get();
 		if(prev.X() != next.X())
 			if((prev.X() <= point.X()) == (point.X() < next.X()))
 			{
@@ -383,3 +391,25 @@ bool Mask::Contains(Point point) const
 	// If the number of intersections is odd, the point is within the mask.
 	return (intersections & 1);
 }
+
+
+
+// Get the number of bytes of memory this mask uses.
+size_t Mask::Bytes() const
+{
+	return sizeof(*this) + outline.capacity() * sizeof(Vertex);
+}
+
+
+
+Mask::Vertex::Vertex(const Point &point)
+	: x(point.X()), y(point.Y())
+{
+}
+
+
+
+Point Mask::Vertex::Get() const
+{
+	return Point(x, y);
+}
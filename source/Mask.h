@@ -16,6 +16,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Angle.h"
 #include "Point.h"
 
+#include <cstddef>
 #include <vector>
 
 class ImageBuffer;
@@ -55,6 +56,9 @@ public:
 	// Find out how close the given point is to the mask.
 	double Range(Point point, Angle facing) const;
 	
+	// Get the number of bytes of memory this mask uses.
+	size_t Bytes() const;
+	
 	
 private:
 	double Intersection(Point sA, Point vA) const;
@@ -62,7 +66,23 @@ private:
 	
 	
 private:
-	std::vector<Point> outline;
+	// The outline is stored as pairs of floats rather than as Points, which are
+	// twice as big (and padded for SSE). Every vertex is a multiple of a quarter
+	// pixel, so no precision is lost.
+	class Vertex {
+	public:
+		Vertex(const Point &point);
+		
+		Point Get() const;
+		
+	private:
+		float x;
+		float y;
+	};
+	
+	
+private:
+	std::vector<Vertex> outline;
 	double radius;
 };
 
@@ -26,6 +26,7 @@ namespace {
 	GLint transformI;
 	GLint positionI;
 	GLint colorI;
+	GLint rectI;
 	
 	GLuint vao;
 	GLuint vbo;
@@ -53,9 +54,15 @@ void OutlineShader::Init()
 	static const char *fragmentCode =
 		"uniform sampler2D tex;\n"
 		"uniform vec4 color = vec4(1, 1, 1, 1);\n"
+		"uniform vec4 rect = vec4(0, 0, 1, 1);\n"
 		"in vec2 tc;\n"
 		"in vec2 off;\n"
 		"out vec4 finalColor;\n"
+		// The sprite may be stored in part of a shared atlas texture.
+		"float alpha(vec2 coord) {\n"
+		"  vec2 halfTexel = .5 / vec2(textureSize(tex, 0));\n"
+		"  return texture(tex, clamp(rect.xy + coord * rect.zw, rect.xy + halfTexel, rect.xy + rect.zw - halfTexel)).a;\n"
+		"}\n"
 		"void main() {\n"
 		"  float sum = 0;\n"
 		"  for(int dy = -1; dy <= 1; ++dy)\n"
@@ -63,14 +70,14 @@ void OutlineShader::Init()
 		"    for(int dx = -1; dx <= 1; ++dx)\n"
 		"    {\n"
 		"      vec2 d = vec2(.618 * dx * off.x, .618 * dy * off.y);\n"
-		"      float ae = texture(tex, d + vec2(tc.x - off.x, tc.y)).a;\n"
-		"      float aw = texture(tex, d + vec2(tc.x + off.x, tc.y)).a;\n"
-		"      float an = texture(tex, d + vec2(tc.x, tc.y - off.y)).a;\n"
-		"      float as = texture(tex, d + vec2(tc.x, tc.y + off.y)).a;\n"
-		"      float ane = texture(tex, d + vec2(tc.x - off.x, tc.y - off.y)).a;\n"
-		"      float anw = texture(tex, d + vec2(tc.x + off.x, tc.y - off.y)).a;\n"
-		"      float ase = texture(tex, d + vec2(tc.x - off.x, tc.y + off.y)).a;\n"
-		"      float asw = texture(tex, d + vec2(tc.x + off.x, tc.y + off.y)).a;\n"
+		"      float ae = alpha(d + vec2(tc.x - off.x, tc.y));\n"
+		"      float aw = alpha(d + vec2(tc.x + off.x, tc.y));\n"
+		"      float an = alpha(d + vec2(tc.x, tc.y - off.y));\n"
+		"      float as = alpha(d + vec2(tc.x, tc.y + off.y));\n"
+		"      float ane = alpha(d + vec2(tc.x - off.x, tc.y - off.y));\n"
+		"      float anw = alpha(d + vec2(tc.x + off.x, tc.y - off.y));\n"
+		"      float ase = alpha(d + vec2(tc.x - off.x, tc.y + off.y));\n"
+		"      float asw = alpha(d + vec2(tc.x + off.x, tc.y + off.y));\n"
 		"      float h = (ae * 2 + ane + ase) - (aw * 2 + anw + asw);\n"
 		"      float v = (an * 2 + ane + anw) - (as * 2 + ase + asw);\n"
 		"      sum += h * h + v * v;\n"
@@ -84,6 +91,7 @@ void OutlineShader::Init()
 	transformI = shader.Uniform("transform");
 	positionI = shader.Uniform("position");
 	colorI = shader.Uniform("color");
+	rectI = shader.Uniform("rect");
 	
 	glUseProgram(shader.Object());
 	glUniform1i(shader.Uniform("tex"), 0);
@@ -120,6 +128,10 @@ void OutlineShader::Init()
 
 void OutlineShader::Draw(const Sprite *sprite, const Point &pos, const Point &size, const Color &color, const Point &unit)
 {
+	const Sprite::Region &region = sprite->GetRegion();
+	if(!region.texture)
+		return;
+	
 	glUseProgram(shader.Object());
 	glBindVertexArray(vao);
 	glActiveTexture(GL_TEXTURE0);
@@ -143,7 +155,8 @@ void OutlineShader::Draw(const Sprite *sprite, const Point &pos, const Point &si
 	
 	glUniform4fv(colorI, 1, color.Get());
 	
-	glBindTexture(GL_TEXTURE_2D, sprite->Texture());
+	glUniform4fv(rectI, 1, region.rect);
+	glBindTexture(GL_TEXTURE_2D, region.texture);
 	
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 	
@@ -29,12 +29,14 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Planet.h"
 #include "Politics.h"
 #include "Random.h"
+#include "SavedGame.h"
 #include "Ship.h"
 #include "ShipEvent.h"
 #include "StartConditions.h"
 #include "StellarObject.h"
 #include "System.h"
 #include "UI.h"
+#include "WriteQueue.h"
 
 #include <ctime>
 #include <sstream>
@@ -92,8 +94,10 @@ void PlayerInfo::New()
 // Load player information from a saved game file.
 void PlayerInfo::Load(const string &path)
 {
-	// Make sure any previously loaded data is cleared.
+	// Make sure any previously loaded data is cleared, and that this file is
+	// not still being written.
 	Clear();
+	WriteQueue::Wait();
 	
 	filePath = path;
 	DataFile file(path);
@@ -247,9 +251,10 @@ void PlayerInfo::Save() const
 		return;
 	
 	// Remember that this was the most recently saved player.
-	Files::Write(Files::Config() + "recent.txt", filePath + '\n');
+	WriteQueue::Add(Files::Config() + "recent.txt", filePath + '\n');
 	
 	Save(filePath);
+	SavedGame::Index(filePath, *this);
 }
 
 
@@ -1664,6 +1669,7 @@ void PlayerInfo::Autosave() const
 	
 	string path = filePath.substr(0, filePath.length() - 4) + "~autosave.txt";
 	Save(path);
+	SavedGame::Index(path, *this);
 }
 
 
@@ -1673,7 +1679,9 @@ void PlayerInfo::Save(const string &path) const
 	if(!planet || !system)
 		return;
 	
-	DataWriter out(path);
+	// Build the whole file in memory, then write it in the background, so the
+	// game does not pause while it is being written.
+	DataWriter out(path, true);
 	
 	out.Write("pilot", firstName, lastName);
 	out.Write("date", date.Day(), date.Month(), date.Year());
@@ -17,21 +17,35 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Screen.h"
 #include "Shader.h"
 
+#include <initializer_list>
 #include <stdexcept>
+#include <vector>
 
 using namespace std;
 
 namespace {
 	Shader shader;
 	GLint scaleI;
-	GLint centerI;
-	GLint angleI;
-	GLint sizeI;
-	GLint offsetI;
-	GLint colorI;
 	
 	GLuint vao;
 	GLuint vbo;
+	
+	// Every vertex carries a copy of its pointer's parameters, so that any
+	// number of pointers can be drawn at once.
+	const int STRIDE = 13;
+	const float CORNERS[3][2] = {
+		{0.f, 0.f}, {0.f, 1.f}, {1.f, 0.f}
+	};
+	// Pointers added since the last call to Bind().
+	vector<GLfloat> vertices;
+	
+	void EnableAttrib(const char *name, int size, int offset)
+	{
+		GLuint attrib = shader.Attrib(name);
+		glEnableVertexAttribArray(attrib);
+		glVertexAttribPointer(attrib, size, GL_FLOAT, GL_FALSE,
+			STRIDE * sizeof(GLfloat), reinterpret_cast<const GLvoid *>(offset * sizeof(GLfloat)));
+	}
 }
 
 
@@ -40,15 +54,21 @@ void PointerShader::Init()
 {
 	static const char *vertexCode =
 		"uniform vec2 scale;\n"
-		"uniform vec2 center;\n"
-		"uniform vec2 angle;\n"
-		"uniform vec2 size;\n"
-		"uniform float offset;\n"
 		
 		"in vec2 vert;\n"
+		"in vec2 center;\n"
+		"in vec2 angle;\n"
+		"in vec2 size;\n"
+		"in float offset;\n"
+		"in vec4 color;\n"
+		
 		"out vec2 coord;\n"
+		"out float pointerWidth;\n"
+		"out vec4 pointerColor;\n"
 		
 		"void main() {\n"
+		"  pointerWidth = size.x;\n"
+		"  pointerColor = color;\n"
 		"  coord = vert * size.x;\n"
 		"  vec2 base = center + angle * (offset - size.y * (vert.x + vert.y));\n"
 		"  vec2 wing = vec2(angle.y, -angle.x) * (size.x * .5 * (vert.x - vert.y));\n"
@@ -56,28 +76,22 @@ void PointerShader::Init()
 		"}\n";
 
 	static const char *fragmentCode =
-		"uniform vec4 color = vec4(1, 1, 1, 1);\n"
-		"uniform vec2 size;\n"
-		
 		"in vec2 coord;\n"
+		"in float pointerWidth;\n"
+		"in vec4 pointerColor;\n"
 		"out vec4 finalColor;\n"
 		
 		"void main() {\n"
-		"  float height = (coord.x + coord.y) / size.x;\n"
+		"  float height = (coord.x + coord.y) / pointerWidth;\n"
 		"  float taper = height * height * height;\n"
-		"  taper *= taper * .5 * size.x;\n"
+		"  taper *= taper * .5 * pointerWidth;\n"
 		"  float alpha = clamp(.8 * min(coord.x, coord.y) - taper, 0, 1);\n"
 		"  alpha *= clamp(1.8 * (1. - height), 0, 1);\n"
-		"  finalColor = color * alpha;\n"
+		"  finalColor = pointerColor * alpha;\n"
 		"}\n";
 	
 	shader = Shader(vertexCode, fragmentCode);
 	scaleI = shader.Uniform("scale");
-	centerI = shader.Uniform("center");
-	angleI = shader.Uniform("angle");
-	sizeI = shader.Uniform("size");
-	offsetI = shader.Uniform("offset");
-	colorI = shader.Uniform("color");
 	
 	// Generate the vertex data for drawing sprites.
 	glGenVertexArrays(1, &vao);
@@ -86,16 +100,12 @@ void PointerShader::Init()
 	glGenBuffers(1, &vbo);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	
-	GLfloat vertexData[] = {
-		0.f, 0.f,
-		0.f, 1.f,
-		1.f, 0.f,
-	};
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertexData), vertexData, GL_STATIC_DRAW);
-	
-	glEnableVertexAttribArray(shader.Attrib("vert"));
-	glVertexAttribPointer(shader.Attrib("vert"), 2, GL_FLOAT, GL_FALSE,
-		2 * sizeof(GLfloat), NULL);
+	EnableAttrib("vert", 2, 0);
+	EnableAttrib("center", 2, 2);
+	EnableAttrib("angle", 2, 4);
+	EnableAttrib("size", 2, 6);
+	EnableAttrib("offset", 1, 8);
+	EnableAttrib("color", 4, 9);
 	
 	// unbind the VBO and VAO
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -120,37 +130,45 @@ void PointerShader::Bind()
 	if(!shader.Object())
 		throw runtime_error("PointerShader: Bind() called before Init().");
 	
-	glUseProgram(shader.Object());
-	glBindVertexArray(vao);
-	
-	GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
-	glUniform2fv(scaleI, 1, scale);
+	vertices.clear();
 }
 
 
 
 void PointerShader::Add(const Point &center, const Point &angle, float width, float height, float offset, const Color &color)
 {
-	GLfloat c[2] = {static_cast<float>(center.X()), static_cast<float>(center.Y())};
-	glUniform2fv(centerI, 1, c);
-	
-	GLfloat a[2] = {static_cast<float>(angle.X()), static_cast<float>(angle.Y())};
-	glUniform2fv(angleI, 1, a);
-	
-	GLfloat size[2] = {width, height};
-	glUniform2fv(sizeI, 1, size);
-	
-	glUniform1f(offsetI, offset);
-	
-	glUniform4fv(colorI, 1, color.Get());
-	
-	glDrawArrays(GL_TRIANGLES, 0, 3);
+	float cx = center.X();
+	float cy = center.Y();
+	float ax = angle.X();
+	float ay = angle.Y();
+	const float *c = color.Get();
+	
+	for(const float *corner : CORNERS)
+		vertices.insert(vertices.end(), {corner[0], corner[1], cx, cy, ax, ay,
+			width, height, offset, c[0], c[1], c[2], c[3]});
 }
 
 
 
+// Draw all the pointers that were added since Bind() with a single draw call.
 void PointerShader::Unbind()
 {
+	if(!vertices.empty())
+	{
+		glUseProgram(shader.Object());
+		glBindVertexArray(vao);
+		
+		GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
+		glUniform2fv(scaleI, 1, scale);
+		
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		
+		glDrawArrays(GL_TRIANGLES, 0, vertices.size() / STRIDE);
+		vertices.clear();
+	}
+	
 	glBindVertexArray(0);
 	glUseProgram(0);
 }
@@ -19,6 +19,8 @@ class Point;
 
 
 // Functions for drawing triangular "pointers," e.g. for target crosshairs.
+// Pointers added between Bind() and Unbind() are all drawn with a single draw
+// call when Unbind() is called.
 class PointerShader {
 public:
 	static void Init();
@@ -42,6 +42,7 @@ namespace {
 	static const string SETTINGS[] = {
 		"Show CPU / GPU load",
 		"Render motion blur",
+		"Reduced star field",
 		"",
 		EXPEND_AMMO,
 		"Automatic firing",
@@ -289,6 +290,9 @@ bool PreferencesPanel::Click(int x, int y)
 				// Make sure there is enough vertical space for the full UI.
 				if(Screen::Height() < 700)
 					Screen::SetZoom(100);
+				// Zooming in uses the @2x images even on an ordinary display.
+				if(Screen::IsHighResolution())
+					GameData::LoadHighDPI();
 				
 				// Convert to raw window coordinates, at the new zoom level.
 				point *= Screen::Zoom() / 100.;
@@ -18,23 +18,36 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Screen.h"
 #include "Shader.h"
 
+#include <initializer_list>
 #include <stdexcept>
+#include <vector>
 
 using namespace std;
 
 namespace {
 	Shader shader;
 	GLint scaleI;
-	GLint positionI;
-	GLint radiusI;
-	GLint widthI;
-	GLint angleI;
-	GLint startAngleI;
-	GLint dashI;
-	GLint colorI;
 	
 	GLuint vao;
 	GLuint vbo;
+	
+	// Each ring is drawn as two triangles. Every vertex carries a copy of the
+	// ring's parameters, so that any number of rings can be drawn at once.
+	const int STRIDE = 13;
+	const float CORNERS[6][2] = {
+		{-1.f, -1.f}, {-1.f, 1.f}, {1.f, -1.f},
+		{-1.f, 1.f}, {1.f, 1.f}, {1.f, -1.f}
+	};
+	// Rings added since the last call to Bind().
+	vector<GLfloat> vertices;
+	
+	void EnableAttrib(const char *name, int size, int offset)
+	{
+		GLuint attrib = shader.Attrib(name);
+		glEnableVertexAttribArray(attrib);
+		glVertexAttribPointer(attrib, size, GL_FLOAT, GL_FALSE,
+			STRIDE * sizeof(GLfloat), reinterpret_cast<const GLvoid *>(offset * sizeof(GLfloat)));
+	}
 }
 
 
@@ -43,53 +56,63 @@ void RingShader::Init()
 {
 	static const char *vertexCode =
 		"uniform vec2 scale;\n"
-		"uniform vec2 position;\n"
-		"uniform float radius;\n"
-		"uniform float width;\n"
 		
 		"in vec2 vert;\n"
+		"in vec2 position;\n"
+		"in float radius;\n"
+		"in float width;\n"
+		"in float angle;\n"
+		"in float startAngle;\n"
+		"in float dash;\n"
+		"in vec4 color;\n"
+		
 		"out vec2 coord;\n"
+		"out float ringRadius;\n"
+		"out float ringWidth;\n"
+		"out float ringAngle;\n"
+		"out float ringStartAngle;\n"
+		"out float ringDash;\n"
+		"out vec4 ringColor;\n"
 		
 		"void main() {\n"
+		"  ringRadius = radius;\n"
+		"  ringWidth = width;\n"
+		"  ringAngle = angle;\n"
+		"  ringStartAngle = startAngle;\n"
+		"  ringDash = dash;\n"
+		"  ringColor = color;\n"
 		"  coord = (radius + width) * vert;\n"
 		"  gl_Position = vec4((coord + position) * scale, 0, 1);\n"
 		"}\n";
 
 	static const char *fragmentCode =
-		"uniform vec4 color = vec4(1, 1, 1, 1);\n"
-		"uniform float radius;\n"
-		"uniform float width;\n"
-		"uniform float angle;\n"
-		"uniform float startAngle;\n"
-		"uniform float dash;\n"
 		"const float pi = 3.1415926535897932384626433832795;\n"
 		
 		"in vec2 coord;\n"
+		"in float ringRadius;\n"
+		"in float ringWidth;\n"
+		"in float ringAngle;\n"
+		"in float ringStartAngle;\n"
+		"in float ringDash;\n"
+		"in vec4 ringColor;\n"
 		"out vec4 finalColor;\n"
 		
 		"void main() {\n"
-		"  float arc = mod(atan(coord.x, coord.y) + pi + startAngle, 2 * pi);\n"
-		"  float arcFalloff = 1 - min(2 * pi - arc, arc - angle) * radius;\n"
-		"  if(dash != 0)\n"
+		"  float arc = mod(atan(coord.x, coord.y) + pi + ringStartAngle, 2 * pi);\n"
+		"  float arcFalloff = 1 - min(2 * pi - arc, arc - ringAngle) * ringRadius;\n"
+		"  if(ringDash != 0)\n"
 		"  {\n"
-		"    arc = mod(arc, dash);\n"
-		"    arcFalloff = min(arcFalloff, min(arc, dash - arc) * radius);\n"
+		"    arc = mod(arc, ringDash);\n"
+		"    arcFalloff = min(arcFalloff, min(arc, ringDash - arc) * ringRadius);\n"
 		"  }\n"
 		"  float len = length(coord);\n"
-		"  float lenFalloff = width - abs(len - radius);\n"
+		"  float lenFalloff = ringWidth - abs(len - ringRadius);\n"
 		"  float alpha = clamp(min(arcFalloff, lenFalloff), 0, 1);\n"
-		"  finalColor = color * alpha;\n"
+		"  finalColor = ringColor * alpha;\n"
 		"}\n";
 	
 	shader = Shader(vertexCode, fragmentCode);
 	scaleI = shader.Uniform("scale");
-	positionI = shader.Uniform("position");
-	radiusI = shader.Uniform("radius");
-	widthI = shader.Uniform("width");
-	angleI = shader.Uniform("angle");
-	startAngleI = shader.Uniform("startAngle");
-	dashI = shader.Uniform("dash");
-	colorI = shader.Uniform("color");
 	
 	// Generate the vertex data for drawing sprites.
 	glGenVertexArrays(1, &vao);
@@ -98,17 +121,14 @@ void RingShader::Init()
 	glGenBuffers(1, &vbo);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	
-	GLfloat vertexData[] = {
-		-1.f, -1.f,
-		-1.f,  1.f,
-		 1.f, -1.f,
-		 1.f,  1.f
-	};
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertexData), vertexData, GL_STATIC_DRAW);
-	
-	glEnableVertexAttribArray(shader.Attrib("vert"));
-	glVertexAttribPointer(shader.Attrib("vert"), 2, GL_FLOAT, GL_FALSE,
-		2 * sizeof(GLfloat), NULL);
+	EnableAttrib("vert", 2, 0);
+	EnableAttrib("position", 2, 2);
+	EnableAttrib("radius", 1, 4);
+	EnableAttrib("width", 1, 5);
+	EnableAttrib("angle", 1, 6);
+	EnableAttrib("startAngle", 1, 7);
+	EnableAttrib("dash", 1, 8);
+	EnableAttrib("color", 4, 9);
 	
 	// unbind the VBO and VAO
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -141,11 +161,7 @@ void RingShader::Bind()
 	if(!shader.Object())
 		throw runtime_error("RingShader: Bind() called before Init().");
 	
-	glUseProgram(shader.Object());
-	glBindVertexArray(vao);
-	
-	GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
-	glUniform2fv(scaleI, 1, scale);
+	vertices.clear();
 }
 
 
@@ -160,24 +176,39 @@ void RingShader::Add(const Point &pos, float out, float in, const Color &color)
 
 void RingShader::Add(const Point &pos, float radius, float width, float fraction, const Color &color, float dash, float startAngle)
 {
-	GLfloat position[2] = {static_cast<float>(pos.X()), static_cast<float>(pos.Y())};
-	glUniform2fv(positionI, 1, position);
-	
-	glUniform1f(radiusI, radius);
-	glUniform1f(widthI, width);
-	glUniform1f(angleI, fraction * 2. * PI);
-	glUniform1f(startAngleI, startAngle * TO_RAD);
-	glUniform1f(dashI, dash ? 2. * PI / dash : 0.);
+	float x = pos.X();
+	float y = pos.Y();
+	float angle = fraction * 2. * PI;
+	float start = startAngle * TO_RAD;
+	float dashAngle = dash ? 2. * PI / dash : 0.;
+	const float *c = color.Get();
 	
-	glUniform4fv(colorI, 1, color.Get());
-	
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	for(const float *corner : CORNERS)
+		vertices.insert(vertices.end(), {corner[0], corner[1], x, y,
+			radius, width, angle, start, dashAngle, c[0], c[1], c[2], c[3]});
 }
 
 
 
+// Draw all the rings that were added since Bind() with a single draw call.
 void RingShader::Unbind()
 {
+	if(!vertices.empty())
+	{
+		glUseProgram(shader.Object());
+		glBindVertexArray(vao);
+		
+		GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
+		glUniform2fv(scaleI, 1, scale);
+		
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		
+		glDrawArrays(GL_TRIANGLES, 0, vertices.size() / STRIDE);
+		vertices.clear();
+	}
+	
 	glBindVertexArray(0);
 	glUseProgram(0);
 }
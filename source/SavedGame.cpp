@@ -14,18 +14,136 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "DataFile.h"
 #include "DataNode.h"
+#include "DataWriter.h"
 #include "Date.h"
+#include "Files.h"
 #include "Format.h"
+#include "PlayerInfo.h"
+#include "Planet.h"
+#include "Ship.h"
 #include "SpriteSet.h"
+#include "System.h"
+#include "WriteQueue.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <sstream>
 
 using namespace std;
 
+namespace {
+	// The summary of one saved game, and the time and size that the file had
+	// when it was made. If either one has changed, the summary is out of date.
+	class Entry {
+	public:
+		time_t timestamp = 0;
+		int64_t size = 0;
+		SavedGame game;
+	};
+	
+	// Every entry in the index, by file name. Games are saved in a background
+	// thread, and are added to the index by that thread once they are written.
+	map<string, Entry> index;
+	bool indexLoaded = false;
+	// Whether games have been added to the index since it was last written.
+	bool indexChanged = false;
+	mutex indexMutex;
+	
+	
+	string IndexPath()
+	{
+		return Files::Saves() + ".index.txt";
+	}
+	
+	
+	// Check whether the given line starts with the given top-level token.
+	bool StartsWith(const string &line, const string &token)
+	{
+		size_t end = token.length();
+		return !line.compare(0, end, token) && (end == line.length() || line[end] <= ' ');
+	}
+	
+	
+	// Read just the top-level nodes of a saved game that the load panel shows:
+	// the pilot, date, and location, the first ship, and the account. Those all
+	// come before the missions, conditions, economy, and so on, so the file is
+	// only read up to the end of the account.
+	string Header(const string &path)
+	{
+		static const string KEYS[] = {"pilot", "date", "system", "planet", "account"};
+		
+		string header;
+		FILE *file = Files::Open(path);
+		if(!file)
+			return header;
+		
+		bool keep = false;
+		bool hasShip = false;
+		bool hasAccount = false;
+		string line;
+		char buffer[4096];
+		while(fgets(buffer, sizeof(buffer), file))
+		{
+			// A line that is longer than the buffer is read in pieces.
+			line += buffer;
+			if(line.back() != '\n' && !feof(file))
+				continue;
+			
+			// Any line that starts with whitespace is a child of the line before
+			// it, and is kept only if its parent is.
+			if(line[0] > ' ' && line[0] != '#')
+			{
+				if(hasAccount)
+					break;
+				
+				keep = false;
+				for(const string &key : KEYS)
+					keep |= StartsWith(line, key);
+				hasAccount = StartsWith(line, "account");
+				if(StartsWith(line, "ship"))
+				{
+					keep = !hasShip;
+					hasShip = true;
+				}
+			}
+			if(keep)
+				header += line;
+			line.clear();
+		}
+		fclose(file);
+		return header;
+	}
+}
+
 
 
+// Load the given saved game. If the index has an up to date summary of it,
+// that is used instead; otherwise, only the parts of the file that hold the
+// information shown in the load panel are parsed.
 void SavedGame::Load(const string &path)
 {
 	Clear();
-	DataFile file(path);
+	ReadIndex();
+	
+	string fileName = Files::Name(path);
+	time_t timestamp = Files::Timestamp(path);
+	int64_t size = Files::Size(path);
+	{
+		lock_guard<mutex> lock(indexMutex);
+		auto it = index.find(fileName);
+		if(it != index.end() && it->second.timestamp == timestamp && it->second.size == size)
+		{
+			*this = it->second.game;
+			this->path = path;
+			return;
+		}
+	}
+	
+	istringstream in(Header(path));
+	DataFile file(in);
 	if(file.begin() != file.end())
 		this->path = path;
 	
@@ -55,10 +173,72 @@ void SavedGame::Load(const string &path)
 				if(child.Token(0) == "name" && child.Size() >= 2)
 					shipName = child.Token(1);
 				else if(child.Token(0) == "sprite" && child.Size() >= 2)
-					shipSprite = SpriteSet::Get(child.Token(1));
+				{
+					shipSpriteName = child.Token(1);
+					shipSprite = SpriteSet::Get(shipSpriteName);
+				}
 			}
 		}
 	}
+	
+	// Add this game to the index, so it will not need to be parsed next time.
+	// The index is written in the background, and if many games are loaded at
+	// once, it is only written once after all of them have been added.
+	if(IsLoaded())
+	{
+		lock_guard<mutex> lock(indexMutex);
+		Entry &entry = index[fileName];
+		entry.timestamp = timestamp;
+		entry.size = size;
+		entry.game = *this;
+		if(!indexChanged)
+		{
+			indexChanged = true;
+			WriteQueue::Then([]()
+			{
+				lock_guard<mutex> lock(indexMutex);
+				if(indexChanged)
+					WriteIndex();
+			});
+		}
+	}
+}
+
+
+
+// Add the given player, which was just saved to the given path, to the index.
+void SavedGame::Index(const string &path, const PlayerInfo &player)
+{
+	// A player who is not on a planet is never saved.
+	if(!player.GetSystem() || !player.GetPlanet())
+		return;
+	ReadIndex();
+	
+	SavedGame game;
+	game.path = path;
+	game.name = player.FirstName() + " " + player.LastName();
+	game.credits = Format::Number(player.Accounts().Credits());
+	game.date = player.GetDate().ToString();
+	game.system = player.GetSystem()->Name();
+	game.planet = player.GetPlanet()->Name();
+	if(!player.Ships().empty())
+	{
+		const Ship &ship = *player.Ships().front();
+		game.shipName = ship.Name();
+		game.shipSpriteName = ship.GetSprite().SpriteName();
+		game.shipSprite = ship.GetSprite().GetSprite();
+	}
+	
+	// The file's time and size are not known until it has been written.
+	WriteQueue::Then([path, game]()
+	{
+		lock_guard<mutex> lock(indexMutex);
+		Entry &entry = index[Files::Name(path)];
+		entry.timestamp = Files::Timestamp(path);
+		entry.size = Files::Size(path);
+		entry.game = game;
+		WriteIndex();
+	});
 }
 
 
@@ -89,6 +269,7 @@ void SavedGame::Clear()
 	planet.clear();
 	
 	shipSprite = nullptr;
+	shipSpriteName.clear();
 	shipName.clear();
 }
 
@@ -140,3 +321,93 @@ const string &SavedGame::ShipName() const
 {
 	return shipName;
 }
+
+
+
+void SavedGame::LoadSummary(const DataNode &node)
+{
+	for(const DataNode &child : node)
+	{
+		if(child.Size() < 2)
+			continue;
+		
+		if(child.Token(0) == "pilot")
+			name = child.Token(1);
+		else if(child.Token(0) == "credits")
+			credits = child.Token(1);
+		else if(child.Token(0) == "date")
+			date = child.Token(1);
+		else if(child.Token(0) == "system")
+			system = child.Token(1);
+		else if(child.Token(0) == "planet")
+			planet = child.Token(1);
+		else if(child.Token(0) == "ship")
+		{
+			shipName = child.Token(1);
+			if(child.Size() >= 3)
+			{
+				shipSpriteName = child.Token(2);
+				shipSprite = SpriteSet::Get(shipSpriteName);
+			}
+		}
+	}
+}
+
+
+
+void SavedGame::SaveSummary(DataWriter &out) const
+{
+	out.Write("pilot", name);
+	out.Write("credits", credits);
+	out.Write("date", date);
+	out.Write("system", system);
+	out.Write("planet", planet);
+	if(!shipSpriteName.empty())
+		out.Write("ship", shipName, shipSpriteName);
+	else if(!shipName.empty())
+		out.Write("ship", shipName);
+}
+
+
+
+void SavedGame::ReadIndex()
+{
+	lock_guard<mutex> lock(indexMutex);
+	if(indexLoaded)
+		return;
+	indexLoaded = true;
+	
+	DataFile file(IndexPath());
+	for(const DataNode &node : file)
+	{
+		if(node.Token(0) != "save" || node.Size() < 4)
+			continue;
+		
+		// Forget about any games that have been deleted since the index was saved.
+		string path = Files::Saves() + node.Token(1);
+		if(!Files::Exists(path))
+			continue;
+		
+		Entry &entry = index[node.Token(1)];
+		entry.timestamp = node.Value(2);
+		entry.size = node.Value(3);
+		entry.game.LoadSummary(node);
+	}
+}
+
+
+
+void SavedGame::WriteIndex()
+{
+	indexChanged = false;
+	DataWriter out(IndexPath(), true);
+	for(const auto &it : index)
+	{
+		out.Write("save", it.first, static_cast<int64_t>(it.second.timestamp), it.second.size);
+		out.BeginChild();
+		{
+			it.second.game.SaveSummary(out);
+		}
+		out.EndChild();
+	}
+}
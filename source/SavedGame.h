@@ -15,6 +15,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include <string>
 
+class DataNode;
+class DataWriter;
+class PlayerInfo;
 class Sprite;
 
 
@@ -23,10 +26,18 @@ class Sprite;
 // information necessary from the file to display it in the "Load Game" panel,
 // without doing all the complicated parsing that PlayerInfo does. This is so
 // that we only need to have one PlayerInfo instance, and there does not need
-// to be logic for copying one PlayerInfo into another.
+// to be logic for copying one PlayerInfo into another. A summary of each game
+// is kept in an index file in the saves folder, so that most of the time the
+// saved game itself does not even need to be read.
 class SavedGame {
 public:
+	// Load the given saved game. If the index has an up to date summary of it,
+	// that is used instead; otherwise, only the parts of the file that hold the
+	// information shown in the load panel are parsed.
 	void Load(const std::string &path);
+	// Add the given player, which was just saved to the given path, to the index.
+	static void Index(const std::string &path, const PlayerInfo &player);
+	
 	const std::string &Path() const;
 	bool IsLoaded() const;
 	void Clear();
@@ -42,6 +53,17 @@ public:
 	const std::string &ShipName() const;
 	
 	
+private:
+	// Read or write this game's summary in the index.
+	void LoadSummary(const DataNode &node);
+	void SaveSummary(DataWriter &out) const;
+	
+	// The index must be read from the main thread, because it looks up sprites.
+	// It must be locked while writing it. It is written in the background.
+	static void ReadIndex();
+	static void WriteIndex();
+	
+	
 private:
 	std::string path;
 	
@@ -53,6 +75,7 @@ private:
 	std::string planet;
 	
 	const Sprite *shipSprite = nullptr;
+	std::string shipSpriteName;
 	std::string shipName;
 };
 
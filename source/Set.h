@@ -13,23 +13,41 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef SET_H_
 #define SET_H_
 
+#include "Handle.h"
+
 #include <map>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 
 
 // Template representing a set of named objects of a given type, where you can
 // query it for a pointer to any object and it will return one, whether or not that
-// object has been loaded yet. (This allows cyclic pointers.)
+// object has been loaded yet. (This allows cyclic pointers.) Lookups go through
+// a hash index, but code that looks up the same object every frame should get
+// a Handle to it once instead.
 template<class Type>
 class Set {
 public:
+	Set() = default;
+	Set(const Set &other);
+	Set &operator=(const Set &other);
+	
 	// Allow non-const access to the owner of this set; it can hand off only
 	// const references to avoid anyone else modifying the objects.
-	Type *Get(const std::string &name) { return &data[name]; }
-	const Type *Get(const std::string &name) const { return &data[name]; }
+	Type *Get(const std::string &name) { return Find(name); }
+	const Type *Get(const std::string &name) const { return Find(name); }
+	Handle<Type> GetHandle(const std::string &name) const { return Handle<Type>(Find(name)); }
 	
-	bool Has(const std::string &name) const { return data.count(name); }
+	// Get the object with the given name in order to load its definition.
+	// Anything that is looked up but never defined is considered an error.
+	Type *Define(const std::string &name);
+	// Get the names of all the objects that were referenced but never defined.
+	std::vector<std::string> Undefined() const;
+	
+	bool Has(const std::string &name) const { return index.count(name); }
 	
 	typename std::map<std::string, Type>::iterator begin() { return data.begin(); }
 	typename std::map<std::string, Type>::const_iterator begin() const { return data.begin(); }
@@ -40,9 +58,75 @@ public:
 	
 	
 private:
+	Type *Find(const std::string &name) const;
+	
+	
+private:
+	// The map owns the objects, so their addresses never change, and keeps
+	// them sorted by name for iteration. The index just speeds up lookups.
 	mutable std::map<std::string, Type> data;
+	mutable std::unordered_map<std::string, Type *> index;
+	std::unordered_set<std::string> defined;
 };
 
 
 
+template<class Type>
+Set<Type>::Set(const Set &other)
+	: data(other.data), defined(other.defined)
+{
+	for(auto &it : data)
+		index[it.first] = &it.second;
+}
+
+
+
+template<class Type>
+Set<Type> &Set<Type>::operator=(const Set &other)
+{
+	data = other.data;
+	defined = other.defined;
+	index.clear();
+	for(auto &it : data)
+		index[it.first] = &it.second;
+	return *this;
+}
+
+
+
+template<class Type>
+Type *Set<Type>::Define(const std::string &name)
+{
+	defined.insert(name);
+	return Find(name);
+}
+
+
+
+template<class Type>
+std::vector<std::string> Set<Type>::Undefined() const
+{
+	std::vector<std::string> names;
+	for(const auto &it : data)
+		if(!defined.count(it.first))
+			names.push_back(it.first);
+	return names;
+}
+
+
+
+template<class Type>
+Type *Set<Type>::Find(const std::string &name) const
+{
+	auto it = index.find(name);
+	if(it != index.end())
+		return it->second;
+	
+	Type *object = &data[name];
+	index[name] = object;
+	return object;
+}
+
+
+
 #endif
@@ -751,7 +751,8 @@ bool Ship::Move(list<Effect> &effects, list<Flotsam> &flotsam)
 		{
 			if(!forget)
 			{
-				const Effect *effect = GameData::Effects().Get("smoke");
+				static const Handle<Effect> smoke = GameData::Effects().GetHandle("smoke");
+				const Effect *effect = smoke.Get();
 				double scale = .015 * (sprite.Width() + sprite.Height()) + .5;
 				double radius = .1 * (sprite.Width() + sprite.Height());
 				int debrisCount = attributes.Get("mass") * .07;
@@ -814,7 +815,8 @@ bool Ship::Move(list<Effect> &effects, list<Flotsam> &flotsam)
 			int count = hyperspaceCount;
 			count *= sprite.Width() * sprite.Height();
 			count /= 160000;
-			const Effect *effect = GameData::Effects().Get("jump drive");
+			static const Handle<Effect> jumpDrive = GameData::Effects().GetHandle("jump drive");
+			const Effect *effect = jumpDrive.Get();
 			while(--count >= 0)
 			{
 				Point point((Random::Real() - .5) * .5 * sprite.Width(),
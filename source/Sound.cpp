@@ -12,8 +12,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Sound.h"
 
-#include "Files.h"
-#include "File.h"
+#include "MappedFile.h"
 
 #ifndef __APPLE__
 #include <AL/al.h>
@@ -21,18 +20,22 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include <OpenAL/al.h>
 #endif
 
-#include <cstdio>
-#include <vector>
+#include <algorithm>
+#include <cstdint>
 
 using namespace std;
 
 namespace {
+	// Sounds with more sample data than this are streamed instead of being
+	// loaded into a buffer all at once. This is about 3 seconds of audio.
+	const size_t STREAM_THRESHOLD = 256 * 1024;
+	
 	// Read a WAV header, and return the size of the data, in bytes. If the file
 	// is an unsupported format (anything but little-endian 16-bit PCM at 44100 HZ),
-	// this will return 0.
-	uint32_t ReadHeader(File &in, uint32_t &frequency);
-	uint32_t Read4(File &in);
-	uint16_t Read2(File &in);
+	// this will return 0. On success, "it" is left pointing to the sample data.
+	uint32_t ReadHeader(const char *&it, const char *end, unsigned &frequency);
+	uint32_t Read4(const char *&it, const char *end);
+	uint16_t Read2(const char *&it, const char *end);
 }
 
 
@@ -44,21 +47,29 @@ void Sound::Load(const string &path)
 	
 	isLooped = path[path.length() - 5] == '~';
 	
-	File in(path);
-	if(!in)
+	// Map the file into memory so the samples can be handed straight to OpenAL
+	// without first being copied into a separate buffer.
+	shared_ptr<MappedFile> in(new MappedFile(path));
+	if(!*in)
+		return;
+	const char *it = in->Data();
+	const char *end = it + in->Size();
+	uint32_t bytes = ReadHeader(it, end, frequency);
+	if(!bytes || bytes > static_cast<size_t>(end - it))
 		return;
-	uint32_t frequency = 0;
-	uint32_t bytes = ReadHeader(in, frequency);
-	if(bytes)
+	
+	size = bytes;
+	if(size > STREAM_THRESHOLD)
 	{
-		vector<char> data(bytes);
-		if(fread(&data[0], 1, bytes, in) != bytes)
-			return;
-		
-		if(!buffer)
-			alGenBuffers(1, &buffer);
-		alBufferData(buffer, AL_FORMAT_MONO16, &data.front(), bytes, frequency);
+		// Keep the file mapped; Audio will read from it as the sound plays.
+		file = in;
+		samples = it;
+		return;
 	}
+	
+	if(!buffer)
+		alGenBuffers(1, &buffer);
+	alBufferData(buffer, AL_FORMAT_MONO16, it, bytes, frequency);
 }
 
 
@@ -77,27 +88,58 @@ bool Sound::IsLooping() const
 
 
 
+// Check if this sound must be streamed rather than played from Buffer().
+bool Sound::IsStreamed() const
+{
+	return samples;
+}
+
+
+
+// Access the raw 16-bit mono samples of a streamed sound.
+const char *Sound::Samples() const
+{
+	return samples;
+}
+
+
+
+unsigned Sound::Frequency() const
+{
+	return frequency;
+}
+
+
+
+// Get the size of this sound's sample data, in bytes.
+size_t Sound::Size() const
+{
+	return size;
+}
+
+
+
 namespace {
 	// Read a WAV header, and return the size of the data, in bytes. If the file
 	// is an unsupported format (anything but little-endian 16-bit PCM at 44100 HZ),
-	// this will return 0.
-	uint32_t ReadHeader(File &in, uint32_t &frequency)
+	// this will return 0. On success, "it" is left pointing to the sample data.
+	uint32_t ReadHeader(const char *&it, const char *end, unsigned &frequency)
 	{
-		uint32_t chunkID = Read4(in);
+		uint32_t chunkID = Read4(it, end);
 		if(chunkID != 0x46464952) // "RIFF" in big endian.
 			return 0;
 		
 		// Ignore the "chunk size".
-		Read4(in);
-		uint32_t format = Read4(in);
+		Read4(it, end);
+		uint32_t format = Read4(it, end);
 		if(format != 0x45564157) // "WAVE"
 			return 0;
 		
 		bool foundHeader = false;
-		while(true)
+		while(it < end)
 		{
-			uint32_t subchunkID = Read4(in);
-			uint32_t subchunkSize = Read4(in);
+			uint32_t subchunkID = Read4(it, end);
+			uint32_t subchunkSize = Read4(it, end);
 			
 			if(subchunkID == 0x20746d66) // "fmt "
 			{
@@ -105,16 +147,16 @@ namespace {
 				if(subchunkSize < 16)
 					return 0;
 				
-				uint16_t audioFormat = Read2(in);
-				uint16_t numChannels = Read2(in);
-				frequency = Read4(in);
-				uint32_t byteRate = Read4(in);
-				uint32_t blockAlign = Read2(in);
-				uint32_t bitsPerSample = Read2(in);
+				uint16_t audioFormat = Read2(it, end);
+				uint16_t numChannels = Read2(it, end);
+				frequency = Read4(it, end);
+				uint32_t byteRate = Read4(it, end);
+				uint32_t blockAlign = Read2(it, end);
+				uint32_t bitsPerSample = Read2(it, end);
 				
 				// Skip any further bytes in this chunk.
 				if(subchunkSize > 16)
-					fseek(in, subchunkSize - 16, SEEK_CUR);
+					it += min<size_t>(subchunkSize - 16, end - it);
 				
 				if(audioFormat != 1)
 					return 0;
@@ -134,33 +176,38 @@ namespace {
 				return subchunkSize;
 			}
 			else
-				fseek(in, subchunkSize, SEEK_CUR);
+				it += min<size_t>(subchunkSize, end - it);
 		}
+		return 0;
 	}
 	
 	
 	
-	uint32_t Read4(File &in)
+	uint32_t Read4(const char *&it, const char *end)
 	{
-		unsigned char data[4];
-		if(fread(data, 1, 4, in) != 4)
+		if(end - it < 4)
+		{
+			it = end;
 			return 0;
+		}
 		uint32_t result = 0;
 		for(int i = 0; i < 4; ++i)
-			result |= static_cast<uint32_t>(data[i]) << (i * 8);
+			result |= static_cast<uint32_t>(static_cast<unsigned char>(*it++)) << (i * 8);
 		return result;
 	}
 	
 	
 	
-	uint16_t Read2(File &in)
+	uint16_t Read2(const char *&it, const char *end)
 	{
-		unsigned char data[2];
-		if(fread(data, 1, 2, in) != 2)
+		if(end - it < 2)
+		{
+			it = end;
 			return 0;
+		}
 		uint16_t result = 0;
 		for(int i = 0; i < 2; ++i)
-			result |= static_cast<uint16_t>(data[i]) << (i * 8);
+			result |= static_cast<uint16_t>(static_cast<unsigned char>(*it++)) << (i * 8);
 		return result;
 	}
 }
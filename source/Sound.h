@@ -13,12 +13,19 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef SOUND_H_
 #define SOUND_H_
 
+#include <cstddef>
+#include <memory>
 #include <string>
 
+class MappedFile;
+
 
 
 // This is a sound that can be played. The sound's file name will determine
-// whether it is looping (ends in '~') or not.
+// whether it is looping (ends in '~') or not. Short sounds are loaded into a
+// single OpenAL buffer; long ones are instead "streamed," i.e. their file stays
+// memory-mapped and each source playing them refills a few small buffers from
+// it as it plays.
 class Sound {
 public:
 	void Load(const std::string &path);
@@ -26,10 +33,23 @@ public:
 	unsigned Buffer() const;
 	bool IsLooping() const;
 	
+	// Check if this sound must be streamed rather than played from Buffer().
+	bool IsStreamed() const;
+	// Access the raw 16-bit mono samples of a streamed sound.
+	const char *Samples() const;
+	unsigned Frequency() const;
+	// Get the size of this sound's sample data, in bytes.
+	size_t Size() const;
+	
 	
 private:
 	unsigned buffer = 0;
 	bool isLooped = false;
+	
+	std::shared_ptr<MappedFile> file;
+	const char *samples = nullptr;
+	size_t size = 0;
+	unsigned frequency = 0;
 };
 
 
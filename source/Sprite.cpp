@@ -12,6 +12,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Sprite.h"
 
+#include "CookedImage.h"
 #include "ImageBuffer.h"
 #include "Screen.h"
 
@@ -19,74 +20,193 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include <SDL2/SDL.h>
 
 #include <algorithm>
+#include <mutex>
 
 using namespace std;
 
+// Not all OpenGL headers define the S3TC formats, since they are an extension.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+namespace {
+	// Frames no bigger than this (in both dimensions) are packed into atlases.
+	const int MAX_ATLAS_FRAME = 256;
+	const int ATLAS_SIZE = 2048;
+	
+	// The atlas is only ever modified from the main (OpenGL) thread, in
+	// AddFrame() and Unload(), so it does not need a mutex.
+	AtlasPacker atlas(ATLAS_SIZE);
+	vector<GLuint> atlasTextures;
+	
+	// Each time a sprite is drawn, it is stamped with the current value of this
+	// clock, which SpriteResidency advances once per frame.
+	atomic<int> useClock(0);
+	// Sprites that were drawn before their textures were loaded.
+	mutex requestMutex;
+	vector<const Sprite *> requests;
+	
+	void SetParameters(int levels = 1)
+	{
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	}
+	
+	// Check whether the graphics driver can use block compressed textures.
+	// This must only be called from the main (OpenGL) thread.
+	bool HasS3TC()
+	{
+		static const bool hasS3TC = SDL_GL_ExtensionSupported("GL_EXT_texture_compression_s3tc");
+		return hasS3TC;
+	}
+	
+	// Get the texture for the given atlas page, creating it if necessary.
+	GLuint AtlasTexture(int page)
+	{
+		if(static_cast<int>(atlasTextures.size()) <= page)
+			atlasTextures.resize(page + 1, 0);
+		GLuint &texture = atlasTextures[page];
+		if(texture)
+			return texture;
+		
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		SetParameters();
+		// Start out with a fully transparent page, so that the padding around
+		// each frame does not contain garbage.
+		vector<uint32_t> empty(ATLAS_SIZE * ATLAS_SIZE, 0);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, ATLAS_SIZE, ATLAS_SIZE, 0,
+			GL_BGRA, GL_UNSIGNED_BYTE, &empty.front());
+		return texture;
+	}
+}
+
 
 
 Sprite::Sprite()
-	: width(0.f), height(0.f)
+	: width(0.f), height(0.f), lastUse(0), isRequested(false), textureBytes(0)
 {
 }
 
 
 
-void Sprite::AddFrame(int frame, ImageBuffer *image, Mask *mask, bool is2x)
+void Sprite::AddFrame(int frame, unique_ptr<ImageBuffer> image, unique_ptr<Mask> mask, bool is2x)
 {
 	if(!image || frame < 0)
 		return;
 	
-	width = max(width, static_cast<float>(image->Width() / (1 + is2x)));
-	height = max(height, static_cast<float>(image->Height() / (1 + is2x)));
-	
-	vector<uint32_t> &textureIndex = (is2x ? textures2x : textures);
-	if(textureIndex.size() <= static_cast<unsigned>(frame))
-		textureIndex.resize(frame + 1, 0);
-	if(!textureIndex[frame])
-		glGenTextures(1, &textureIndex[frame]);
-	glBindTexture(GL_TEXTURE_2D, textureIndex[frame]);
-	
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	Frame &it = Replace(frame, image->Width() / (1 + is2x), image->Height() / (1 + is2x), is2x);
 	
 	// ImageBuffer always loads images into 32-bit BGRA buffers.
 	// That is supposedly the fastest format to upload.
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image->Width(), image->Height(), 0,
-		GL_BGRA, GL_UNSIGNED_BYTE, image->Pixels());
-	
-	glBindTexture(GL_TEXTURE_2D, 0);
-	delete image;
-	
-	if(mask)
+	if(!AddToAtlas(it, image->Width(), image->Height(), image->Pixels()))
 	{
-		if(masks.size() <= static_cast<unsigned>(frame))
-			masks.resize(frame + 1);
-		masks[frame] = move(*mask);
-		delete mask;
+		glGenTextures(1, &it.region.texture);
+		glBindTexture(GL_TEXTURE_2D, it.region.texture);
+		SetParameters();
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image->Width(), image->Height(), 0,
+			GL_BGRA, GL_UNSIGNED_BYTE, image->Pixels());
 	}
+	it.bytes = 4 * static_cast<int64_t>(image->Width()) * image->Height();
+	textureBytes += it.bytes;
+	glBindTexture(GL_TEXTURE_2D, 0);
+	
+	// OpenGL has its own copy of the pixels now.
+	image.reset();
+	AddMask(frame, move(mask));
 }
 
 
 
-// Free up all textures loaded for this sprite.
-void Sprite::Unload()
+// Add a frame from a cooked image.
+void Sprite::AddFrame(int frame, unique_ptr<CookedImage> image, unique_ptr<Mask> mask, bool is2x)
 {
-	if(!textures.empty())
+	if(!image || frame < 0)
+		return;
+	
+	// If the driver cannot handle compressed textures, fall back to uploading
+	// the uncompressed full size image and letting the driver make mipmaps.
+	if(image->GetFormat() != CookedImage::BGRA && !HasS3TC())
 	{
-		glDeleteTextures(textures.size(), &textures.front());
-		textures.clear();
+		int levels = image->Levels();
+		unique_ptr<ImageBuffer> buffer(image->Decode());
+		image.reset();
+		if(!buffer)
+			return;
+		AddFrame(frame, move(buffer), move(mask), is2x);
+		
+		Frame &it = (is2x ? frames2x : frames)[frame];
+		if(levels > 1 && it.slot.page < 0)
+		{
+			glBindTexture(GL_TEXTURE_2D, it.region.texture);
+			SetParameters(levels);
+			glGenerateMipmap(GL_TEXTURE_2D);
+			glBindTexture(GL_TEXTURE_2D, 0);
+			// The mipmaps take up another third as much memory.
+			int64_t mipmapBytes = it.bytes / 3;
+			it.bytes += mipmapBytes;
+			textureBytes += mipmapBytes;
+		}
+		return;
 	}
-	if(!textures2x.empty())
+	
+	Frame &it = Replace(frame, image->Width() / (1 + is2x), image->Height() / (1 + is2x), is2x);
+	
+	bool isAtlas = (image->GetFormat() == CookedImage::BGRA && image->Levels() == 1
+		&& AddToAtlas(it, image->Width(), image->Height(), &image->Data(0).front()));
+	if(!isAtlas)
 	{
-		glDeleteTextures(textures2x.size(), &textures2x.front());
-		textures2x.clear();
+		glGenTextures(1, &it.region.texture);
+		glBindTexture(GL_TEXTURE_2D, it.region.texture);
+		SetParameters(image->Levels());
+		GLenum format = (image->GetFormat() == CookedImage::BC1) ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+			: GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		for(int level = 0; level < image->Levels(); ++level)
+		{
+			const vector<uint8_t> &data = image->Data(level);
+			if(image->GetFormat() == CookedImage::BGRA)
+				glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, image->Width(level), image->Height(level), 0,
+					GL_BGRA, GL_UNSIGNED_BYTE, &data.front());
+			else
+				glCompressedTexImage2D(GL_TEXTURE_2D, level, format, image->Width(level), image->Height(level), 0,
+					data.size(), &data.front());
+		}
 	}
+	for(int level = 0; level < image->Levels(); ++level)
+		it.bytes += image->Data(level).size();
+	textureBytes += it.bytes;
+	glBindTexture(GL_TEXTURE_2D, 0);
 	
-	masks.clear();
-	width = 0.f;
-	height = 0.f;
+	image.reset();
+	AddMask(frame, move(mask));
+}
+
+
+
+// Free up all textures loaded for this sprite. The frames themselves are kept,
+// but with empty regions, so the sprite can still be used (e.g. for collision
+// detection) and drawing it will ask for it to be loaded again.
+void Sprite::Unload()
+{
+	for(Frame &frame : frames)
+		Free(frame);
+	for(Frame &frame : frames2x)
+		Free(frame);
+	isRequested = false;
+}
+
+
+
+// Check whether a frame of the given size will be packed into an atlas.
+bool Sprite::FitsAtlas(int width, int height)
+{
+	return (width <= MAX_ATLAS_FRAME && height <= MAX_ATLAS_FRAME);
 }
 
 
@@ -107,7 +227,7 @@ float Sprite::Height() const
 
 int Sprite::Frames() const
 {
-	return textures.size();
+	return frames.size();
 }
 
 
@@ -119,15 +239,39 @@ Point Sprite::Center() const
 
 
 
-uint32_t Sprite::Texture(int frame) const
+// Get the texture that the given frame is stored in, and where in that
+// texture the frame is. The texture may be shared with other sprites.
+const Sprite::Region &Sprite::GetRegion(int frame) const
 {
-	if(Screen::IsHighResolution() && !textures2x.empty())
-		return textures2x[frame % textures2x.size()];
+	static const Region empty;
+	// Record that this sprite is in use. If it has no textures, ask for them to
+	// be loaded, but only once until they are loaded or unloaded again.
+	lastUse.store(useClock.load(memory_order_relaxed), memory_order_relaxed);
+	if(!textureBytes.load(memory_order_relaxed) && !isRequested.exchange(true))
+	{
+		lock_guard<mutex> lock(requestMutex);
+		requests.push_back(this);
+	}
 	
-	if(textures.empty())
-		return 0;
+	// Fall back to the ordinary frame if the @2x one is not loaded yet.
+	if(Screen::IsHighResolution() && !frames2x.empty())
+	{
+		const Region &region = frames2x[frame % frames2x.size()].region;
+		if(region.texture)
+			return region;
+	}
+	
+	if(frames.empty())
+		return empty;
 	
-	return textures[frame % textures.size()];
+	return frames[frame % frames.size()].region;
+}
+
+
+
+uint32_t Sprite::Texture(int frame) const
+{
+	return GetRegion(frame).texture;
 }
 
 
@@ -135,8 +279,103 @@ uint32_t Sprite::Texture(int frame) const
 const Mask &Sprite::GetMask(int frame) const
 {
 	static const Mask empty;
-	if(masks.empty() || masks.size() != textures.size())
+	if(masks.empty() || masks.size() != frames.size())
 		return empty;
 	
 	return masks[frame % masks.size()];
 }
+
+
+
+// Set the number of frames and the size of a sprite that is not loaded yet.
+void Sprite::Reserve(int count, int count2x, int width, int height, bool hasMasks)
+{
+	this->width = max(this->width, static_cast<float>(width));
+	this->height = max(this->height, static_cast<float>(height));
+	if(frames.size() < static_cast<unsigned>(count))
+		frames.resize(count);
+	if(frames2x.size() < static_cast<unsigned>(count2x))
+		frames2x.resize(count2x);
+	if(hasMasks && masks.size() < static_cast<unsigned>(count))
+		masks.resize(count);
+}
+
+
+
+// Advance the clock that is used to record when each sprite was last drawn.
+int Sprite::AdvanceClock()
+{
+	return ++useClock;
+}
+
+
+
+// Get all the sprites that have been drawn without being loaded.
+vector<const Sprite *> Sprite::TakeRequests()
+{
+	vector<const Sprite *> result;
+	lock_guard<mutex> lock(requestMutex);
+	result.swap(requests);
+	return result;
+}
+
+
+
+// Get the given frame, freeing anything already loaded there.
+Sprite::Frame &Sprite::Replace(int frame, int width, int height, bool is2x)
+{
+	this->width = max(this->width, static_cast<float>(width));
+	this->height = max(this->height, static_cast<float>(height));
+	
+	vector<Frame> &frameIndex = (is2x ? frames2x : frames);
+	if(frameIndex.size() <= static_cast<unsigned>(frame))
+		frameIndex.resize(frame + 1);
+	Frame &it = frameIndex[frame];
+	Free(it);
+	return it;
+}
+
+
+
+// Try to put the given pixels into an atlas.
+bool Sprite::AddToAtlas(Frame &it, int width, int height, const void *pixels)
+{
+	if(!FitsAtlas(width, height) || !atlas.Add(width, height, it.slot))
+		return false;
+	
+	it.region.texture = AtlasTexture(it.slot.page);
+	glBindTexture(GL_TEXTURE_2D, it.region.texture);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, it.slot.x, it.slot.y, width, height,
+		GL_BGRA, GL_UNSIGNED_BYTE, pixels);
+	
+	float scale = 1.f / ATLAS_SIZE;
+	it.region.rect[0] = it.slot.x * scale;
+	it.region.rect[1] = it.slot.y * scale;
+	it.region.rect[2] = it.slot.width * scale;
+	it.region.rect[3] = it.slot.height * scale;
+	return true;
+}
+
+
+
+void Sprite::AddMask(int frame, unique_ptr<Mask> mask)
+{
+	if(!mask)
+		return;
+	
+	if(masks.size() <= static_cast<unsigned>(frame))
+		masks.resize(frame + 1);
+	masks[frame] = move(*mask);
+}
+
+
+
+void Sprite::Free(Frame &frame)
+{
+	if(frame.slot.page >= 0)
+		atlas.Remove(frame.slot);
+	else if(frame.region.texture)
+		glDeleteTextures(1, &frame.region.texture);
+	textureBytes -= frame.bytes;
+	frame = Frame();
+}
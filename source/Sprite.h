@@ -13,30 +13,59 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef SPRITE_H_
 #define SPRITE_H_
 
+#include "AtlasPacker.h"
 #include "Mask.h"
 #include "Point.h"
 
+#include <atomic>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
+class CookedImage;
 class ImageBuffer;
 
 
 
 // Class representing a drawable sprite. A sprite can have multiple frames, for
 // animation. Certain sprites will also include a "mask" that can be used to
-// check whether something has collided with them. Each frame is stored in a
-// separate OpenGL texture object. This may not be as efficient as sprite
-// sheets, but with modern graphics cards it will not matter much and it makes
-// working with the graphics a lot simpler.
+// check whether something has collided with them. Large frames are each stored
+// in a separate OpenGL texture object, but small ones (e.g. projectiles and
+// effects) are packed together into shared "atlas" textures, so that many of
+// them can be drawn without switching textures. A sprite's textures may be
+// loaded only when it is first drawn, and freed again if it goes unused for
+// long enough; its size, frame count and masks stay available either way.
+// Sprites are drawn from the game's calculation thread, so they are only ever
+// changed from the main thread at times when that thread is idle.
 class Sprite {
+public:
+	// The part of a texture that holds one frame of this sprite.
+	class Region {
+	public:
+		uint32_t texture = 0;
+		// The (x, y) offset and (width, height) of the frame within the
+		// texture, in texture coordinates.
+		float rect[4] = {0.f, 0.f, 1.f, 1.f};
+	};
+	
+	
 public:
 	Sprite();
 	
-	void AddFrame(int frame, ImageBuffer *image, Mask *mask, bool is2x);
-	// Free up all textures loaded for this sprite.
+	// Add a frame, taking ownership of its image and mask. The image is freed
+	// as soon as it has been uploaded to OpenGL.
+	void AddFrame(int frame, std::unique_ptr<ImageBuffer> image, std::unique_ptr<Mask> mask, bool is2x);
+	// Add a frame from a cooked image, which may include mipmaps and may be
+	// block compressed.
+	void AddFrame(int frame, std::unique_ptr<CookedImage> image, std::unique_ptr<Mask> mask, bool is2x);
+	// Free up all textures loaded for this sprite. Its size, number of frames,
+	// and masks are kept, so that it can still be used until it is reloaded.
 	void Unload();
 	
+	// Check whether a frame of the given size will be packed into an atlas.
+	// Such frames are never mipmapped or compressed.
+	static bool FitsAtlas(int width, int height);
+	
 	float Width() const;
 	float Height() const;
 	int Frames() const;
@@ -45,17 +74,64 @@ public:
 	// shifting of corner to center coordinates.
 	Point Center() const;
 	
+	// Get the texture that the given frame is stored in, and where in that
+	// texture the frame is. The texture may be shared with other sprites. This
+	// also marks the sprite as being in use; if its textures are not loaded,
+	// the region is empty and the sprite is added to the list of requests.
+	const Region &GetRegion(int frame = 0) const;
 	uint32_t Texture(int frame = 0) const;
 	const Mask &GetMask(int frame = 0) const;
 	
 	
 private:
-	std::vector<uint32_t> textures;
-	std::vector<uint32_t> textures2x;
+	class Frame {
+	public:
+		Region region;
+		// If this frame is in a shared atlas, this is where.
+		AtlasPacker::Slot slot;
+		// How much texture memory this frame takes up.
+		int64_t bytes = 0;
+	};
+	
+	
+private:
+	// Only SpriteResidency decides which sprites are loaded.
+	friend class SpriteResidency;
+	// Set the number of frames (ordinary and @2x) and the size of a sprite
+	// whose images have not been loaded yet, so that it can be used before it
+	// is drawn. Room is made for all the frames and masks up front, so that
+	// loading them never reallocates anything that is being read.
+	void Reserve(int frames, int frames2x, int width, int height, bool hasMasks);
+	// Advance the clock that is used to record when each sprite was last drawn.
+	static int AdvanceClock();
+	// Get all the sprites that have been drawn without being loaded since the
+	// last time this was called.
+	static std::vector<const Sprite *> TakeRequests();
+	
+	// Get the given frame, freeing anything already loaded there, and update
+	// the sprite's dimensions to include it.
+	Frame &Replace(int frame, int width, int height, bool is2x);
+	// Try to put the given pixels into an atlas, returning false if no atlas
+	// has room for them.
+	bool AddToAtlas(Frame &it, int width, int height, const void *pixels);
+	void AddMask(int frame, std::unique_ptr<Mask> mask);
+	void Free(Frame &frame);
+	
+	
+private:
+	std::vector<Frame> frames;
+	std::vector<Frame> frames2x;
 	std::vector<Mask> masks;
 	
 	float width;
 	float height;
+	
+	// Drawing happens in the game's calculation thread as well as in the main
+	// thread, so the usage tracking must be thread safe.
+	mutable std::atomic<int> lastUse;
+	mutable std::atomic<bool> isRequested;
+	// The approximate size of the textures loaded for this sprite.
+	std::atomic<int64_t> textureBytes;
 };
 
 
@@ -12,31 +12,34 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "SpriteQueue.h"
 
+#include "AssetManifest.h"
+#include "CookedImage.h"
+#include "Files.h"
 #include "ImageBuffer.h"
 #include "Mask.h"
 #include "Sprite.h"
 #include "SpriteSet.h"
+#include "StartupProfile.h"
 
+#include <algorithm>
 #include <functional>
 
 using namespace std;
 
 namespace {
-	// Check if the given image is an @2x image.
-	bool Is2x(const string &path)
+	// Ships and asteroids need collision masks. The @2x sprites never get masks
+	// of their own; they just use the ordinary sprite masks instead.
+	bool HasMask(const string &name)
 	{
-		size_t len = path.length();
-		return (len > 7 && path[len - 7] == '@' && path[len - 6] == '2' && path[len - 5] == 'x');
+		return (!name.compare(0, 5, "ship/") || !name.compare(0, 9, "asteroid/"));
 	}
 }
 
 
 
 SpriteQueue::SpriteQueue()
-	: added(0), completed(0), threads(4)
+	: added(0), completed(0)
 {
-	for(thread &t : threads)
-		t = thread(ref(*this));
 }
 
 
@@ -54,26 +57,75 @@ SpriteQueue::~SpriteQueue()
 
 
 
+// Set how many worker threads to use.
+void SpriteQueue::SetThreadCount(int loaders)
+{
+	lock_guard<mutex> lock(readMutex);
+	threadCount = max(0, loaders);
+}
+
+
+
 // Add a sprite to load.
-void SpriteQueue::Add(const string &name, const string &path)
+void SpriteQueue::Add(const string &name, const string &path, Priority priority, bool halfSize)
 {
 	Sprite *sprite = SpriteSet::Modify(name);
+	// The file size is only used to estimate progress, so the size from the
+	// manifest is good enough even if it is out of date.
+	int64_t bytes = AssetManifest::Size(path);
 	{
 		lock_guard<mutex> lock(readMutex);
 		// Do nothing if we are destroying the queue already.
 		if(added < 0)
 			return;
 		
-		bool is2x = Is2x(path);
+		bool is2x = Is2x(path) && !halfSize;
 		int &frame = (is2x ? count2x[name] : count[name]);
-		toRead.emplace(sprite, name, path, frame++, is2x);
-		++added;
+		// If the sprite has been loaded before, its mask was kept when it was
+		// unloaded, so there is no need to create it again.
+		bool needsMask = !is2x && HasMask(name) && !sprite->GetMask(frame).IsLoaded();
+		Queue(sprite, name, path, frame++, is2x, halfSize, needsMask, priority, bytes);
+	}
+	readCondition.notify_one();
+}
+
+
+
+// Read the given image file again, and replace the given frame of its sprite
+// with it. The old texture is used until the new one is ready.
+void SpriteQueue::Reload(const string &name, const string &path, int frame, bool halfSize)
+{
+	Sprite *sprite = SpriteSet::Modify(name);
+	// The file has just been changed, so its size in the manifest is out of date.
+	int64_t bytes = Files::Size(path);
+	{
+		lock_guard<mutex> lock(readMutex);
+		if(added < 0)
+			return;
+		
+		// The image may have changed shape, so its mask must be created again.
+		bool is2x = Is2x(path) && !halfSize;
+		Queue(sprite, name, path, frame, is2x, halfSize, !is2x && HasMask(name), IMMEDIATE, bytes);
 	}
 	readCondition.notify_one();
 }
 
 
 
+// Change the priority of any frames of the given sprite that are still
+// waiting to be read from disk or uploaded.
+void SpriteQueue::Prioritize(const Sprite *sprite, Priority priority)
+{
+	{
+		lock_guard<mutex> lock(readMutex);
+		Prioritize(toRead, sprite, priority);
+	}
+	lock_guard<mutex> lock(loadMutex);
+	Prioritize(toLoad, sprite, priority);
+}
+
+
+
 // Unload the texture for the given sprite (to free up memory).
 void SpriteQueue::Unload(const string &name)
 {
@@ -81,6 +133,9 @@ void SpriteQueue::Unload(const string &name)
 		lock_guard<mutex> lock(readMutex);
 		count2x[name] = 0;
 		count[name] = 0;
+		// If the sprite is loaded again, its frames are numbered from zero,
+		// so anything queued for it before now must not be uploaded.
+		++generation[SpriteSet::Get(name)];
 	}
 	
 	unique_lock<mutex> lock(loadMutex);
@@ -89,7 +144,7 @@ void SpriteQueue::Unload(const string &name)
 
 
 
-// Find out our percent completion.
+// Upload whatever has been read so far, and find out our percent completion.
 double SpriteQueue::Progress() const
 {
 	unique_lock<mutex> lock(loadMutex);
@@ -98,6 +153,15 @@ double SpriteQueue::Progress() const
 
 
 
+// Find out our percent completion without uploading anything.
+double SpriteQueue::Completion() const
+{
+	lock_guard<mutex> lock(loadMutex);
+	return DoCompletion();
+}
+
+
+
 // Finish loading.
 void SpriteQueue::Finish() const
 {
@@ -133,25 +197,46 @@ void SpriteQueue::operator()()
 			if(toRead.empty())
 				break;
 			
-			Item item = toRead.front();
-			toRead.pop();
+			pop_heap(toRead.begin(), toRead.end());
+			Item item = move(toRead.back());
+			toRead.pop_back();
+			// If the sprite has been unloaded since this item was queued, just
+			// pass the item on so that it is counted as complete.
+			bool isStale = IsStale(item);
 			
 			lock.unlock();
 			
-			// Load the sprite.
-			item.image = ImageBuffer::Read(item.path);
-			// If sprite loading fails, just skip this sprite.
-			if(!item.image)
+			if(!isStale)
 			{
-				lock.lock();
-				continue;
-			}
-			// Don't ever create masks for @2x sprites; just use the ordinary
-			// sprite masks instead.
-			if(!item.is2x && (!item.name.compare(0, 5, "ship/") || !item.name.compare(0, 9, "asteroid/")))
-			{
-				item.mask = new Mask;
-				item.mask->Create(item.image);
+				StartupProfile::Phase phase("sprite decode", item.path);
+				// Load the sprite, preferring a cooked image if there is one.
+				if(IsCooked(item.path))
+					item.cooked.reset(CookedImage::Read(item.path));
+				else
+					item.image.reset(ImageBuffer::Read(item.path, item.halfSize));
+				// A cooked image can be shrunk by dropping its largest mipmap, if it
+				// has any. Otherwise, it must be decoded and then shrunk.
+				if(item.cooked && item.halfSize && !item.cooked->ShrinkToHalfSize())
+				{
+					item.image.reset(item.cooked->Decode());
+					item.image->ShrinkToHalfSize();
+					item.cooked.reset();
+				}
+				// If sprite loading fails, the item is still passed on with no image,
+				// so that it is counted as complete; Sprite::AddFrame() ignores it.
+				bool isLoaded = (item.image || item.cooked);
+				if(isLoaded && item.needsMask)
+				{
+					item.mask.reset(new Mask);
+					if(item.cooked)
+					{
+						// A compressed image must be decoded to find its outline.
+						unique_ptr<ImageBuffer> image(item.cooked->Decode());
+						item.mask->Create(image.get());
+					}
+					else
+						item.mask->Create(item.image.get());
+				}
 			}
 			
 			// Don't bother to copy the path, now that we've loaded the file.
@@ -159,8 +244,9 @@ void SpriteQueue::operator()()
 			item.path.clear();
 			{
 				// The texture must be uploaded to OpenGL in the main thread.
-				unique_lock<mutex> lock(loadMutex);
-				toLoad.push(item);
+				lock_guard<mutex> loadLock(loadMutex);
+				toLoad.push_back(move(item));
+				push_heap(toLoad.begin(), toLoad.end());
 			}
 			loadCondition.notify_one();
 			
@@ -172,6 +258,34 @@ void SpriteQueue::operator()()
 }
 
 
+// Add an item to be read. The caller must hold the read mutex.
+void SpriteQueue::Queue(Sprite *sprite, const string &name, const string &path, int frame, bool is2x,
+	bool halfSize, bool needsMask, Priority priority, int64_t bytes)
+{
+	// The worker threads are not started until they are needed, so that
+	// SetThreadCount() can be called first. If the number of cores is not
+	// known, fall back to four threads.
+	if(threads.empty())
+	{
+		int loaders = threadCount ? threadCount : thread::hardware_concurrency();
+		threads.resize(loaders ? loaders : 4);
+		for(thread &t : threads)
+			t = thread(ref(*this));
+	}
+	
+	toRead.emplace_back(sprite, name, path, frame, is2x, halfSize);
+	toRead.back().priority = priority;
+	toRead.back().sequence = sequence++;
+	toRead.back().bytes = bytes;
+	toRead.back().needsMask = needsMask;
+	toRead.back().generation = generation[sprite];
+	push_heap(toRead.begin(), toRead.end());
+	++added;
+	addedBytes += bytes;
+}
+
+
+
 double SpriteQueue::DoLoad(unique_lock<mutex> &lock) const
 {
 	while(!toUnload.empty())
@@ -186,29 +300,111 @@ double SpriteQueue::DoLoad(unique_lock<mutex> &lock) const
 	
 	for(int i = 0; !toLoad.empty() && i < 30; ++i)
 	{
-		Item item = toLoad.front();
-		toLoad.pop();
+		pop_heap(toLoad.begin(), toLoad.end());
+		Item item = move(toLoad.back());
+		toLoad.pop_back();
 		
 		lock.unlock();
 		
-		item.sprite->AddFrame(item.frame, item.image, item.mask, item.is2x);
+		// Skip anything that was queued before its sprite was unloaded. Only
+		// this thread unloads sprites, so this cannot change before the upload.
+		bool isStale = false;
+		{
+			lock_guard<mutex> readLock(readMutex);
+			isStale = IsStale(item);
+		}
+		if(!isStale)
+		{
+			StartupProfile::Phase phase("sprite upload");
+			if(item.cooked)
+				item.sprite->AddFrame(item.frame, move(item.cooked), move(item.mask), item.is2x);
+			else
+				item.sprite->AddFrame(item.frame, move(item.image), move(item.mask), item.is2x);
+		}
 		
 		lock.lock();
 		++completed;
+		completedBytes += item.bytes;
 	}
 	
+	return DoCompletion();
+}
+
+
+
+// Find our percent completion. The caller must hold the load mutex.
+double SpriteQueue::DoCompletion() const
+{
 	// Wait until we have completed loading of as many sprites as we have added.
 	// The value of "added" is protected by readMutex.
 	unique_lock<mutex> readLock(readMutex);
 	// Special cases: we're bailing out, or we are done.
 	if(added <= 0 || added == completed)
 		return 1.;
-	return static_cast<double>(completed) / static_cast<double>(added);
+	if(addedBytes <= 0)
+		return static_cast<double>(completed) / static_cast<double>(added);
+	return min(1., static_cast<double>(completedBytes) / static_cast<double>(addedBytes));
+}
+
+
+
+// Check if the given image is a cooked image.
+bool SpriteQueue::IsCooked(const string &path)
+{
+	size_t len = path.length();
+	return (len > 4 && !path.compare(len - 4, 4, ".tex"));
+}
+
+
+
+// Check if the given image is an @2x image.
+bool SpriteQueue::Is2x(const string &path)
+{
+	size_t len = path.length() - (IsCooked(path) ? 4 : 0);
+	return (len > 7 && path[len - 7] == '@' && path[len - 6] == '2' && path[len - 5] == 'x');
+}
+
+
+
+// Check if the given item was queued before its sprite was last unloaded.
+// The caller must hold the read mutex.
+bool SpriteQueue::IsStale(const Item &item) const
+{
+	auto it = generation.find(item.sprite);
+	return (it == generation.end() ? 0 : it->second) != item.generation;
+}
+
+
+
+// Change the priority of any items in the given heap for the given sprite.
+void SpriteQueue::Prioritize(vector<Item> &heap, const Sprite *sprite, Priority priority)
+{
+	bool changed = false;
+	for(Item &item : heap)
+		if(item.sprite == sprite && item.priority != priority)
+		{
+			item.priority = priority;
+			changed = true;
+		}
+	if(changed)
+		make_heap(heap.begin(), heap.end());
+}
+
+
+
+SpriteQueue::Item::Item(Sprite *sprite, const string &name, const string &path, int frame, bool is2x, bool halfSize)
+	: sprite(sprite), name(name), path(path), frame(frame), is2x(is2x), halfSize(halfSize)
+{
 }
 
 
 
-SpriteQueue::Item::Item(Sprite *sprite, const string &name, const string &path, int frame, bool is2x)
-	: sprite(sprite), name(name), path(path), image(nullptr), mask(nullptr), frame(frame), is2x(is2x)
+// Items are kept in a heap, so the "greatest" item is the one that should be
+// loaded first: the one with the lowest priority value, or if two items have
+// the same priority, the one that was added first.
+bool SpriteQueue::Item::operator<(const Item &other) const
 {
+	if(priority != other.priority)
+		return priority > other.priority;
+	return sequence > other.sequence;
 }
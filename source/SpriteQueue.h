@@ -14,13 +14,16 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #define SPRITE_QUEUE_H_
 
 #include <condition_variable>
+#include <cstdint>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <string>
 #include <thread>
 #include <vector>
 
+class CookedImage;
 class ImageBuffer;
 class Mask;
 class Sprite;
@@ -28,61 +31,138 @@ class Sprite;
 
 
 // Class for queuing up a list of sprites to be loaded from the disk, with a set of
-// worker threads that begins loading them as soon as they are added.
+// worker threads that begins loading them as soon as they are added. Sprites
+// are loaded in order of priority, and within the same priority in the order
+// that they were added.
 class SpriteQueue {
+public:
+	enum Priority {
+		// Sprites that are needed right now, e.g. the landscape of the planet
+		// that the player is landing on.
+		IMMEDIATE,
+		// The user interface, and sprites in the player's current system.
+		INTERFACE,
+		// The player's ships.
+		PLAYER,
+		// Everything else.
+		NORMAL
+	};
+	
+	
 public:
 	SpriteQueue();
 	~SpriteQueue();
 	
-	// Add a sprite to load.
-	void Add(const std::string &name, const std::string &path);
-	// Unload the texture for the given sprite (to free up memory).
+	// Set how many worker threads to use. This must be done before the first
+	// sprite is added. By default there is one per processor core.
+	void SetThreadCount(int loaders);
+	
+	// Add a sprite to load, with the given priority. If halfSize is set, the
+	// path is an @2x image that should be loaded at half size as the sprite's
+	// ordinary frame.
+	void Add(const std::string &name, const std::string &path, Priority priority = NORMAL, bool halfSize = false);
+	// Read the given image file again, and replace the given frame of its
+	// sprite with it. The old texture is used until the new one is ready.
+	void Reload(const std::string &name, const std::string &path, int frame, bool halfSize = false);
+	// Change the priority of any frames of the given sprite that are still
+	// waiting to be read from disk or uploaded.
+	void Prioritize(const Sprite *sprite, Priority priority);
+	// Unload the texture for the given sprite (to free up memory). Any of its
+	// frames that are still waiting to be read or uploaded are dropped.
 	void Unload(const std::string &name);
-	// Find out our percent completion.
+	// Upload whatever has been read so far and apply any unloads, and find out
+	// our percent completion. Each sprite is weighted by the size of its file,
+	// since that is a better measure of how long it takes to load. This changes
+	// sprites, so it must only be called while nothing else is drawing them.
 	double Progress() const;
+	// Find out our percent completion without uploading anything.
+	double Completion() const;
 	// Finish loading.
 	void Finish() const;
 	
 	// Thread entry point.
 	void operator()();
 	
+	// Check if the given image is a cooked image. Its path is the path of the
+	// original image, with ".tex" appended.
+	static bool IsCooked(const std::string &path);
+	// Check if the given image (cooked or not) is an @2x image.
+	static bool Is2x(const std::string &path);
+	
 	
 private:
+	// Add an item to be read. The caller must hold the read mutex.
+	void Queue(Sprite *sprite, const std::string &name, const std::string &path, int frame, bool is2x,
+		bool halfSize, bool needsMask, Priority priority, int64_t bytes);
 	double DoLoad(std::unique_lock<std::mutex> &lock) const;
+	// Find our percent completion. The caller must hold the load mutex.
+	double DoCompletion() const;
 	
 	
 private:
 	class Item {
 	public:
-		Item(Sprite *sprite, const std::string &name, const std::string &path, int frame, bool is2x);
+		Item(Sprite *sprite, const std::string &name, const std::string &path, int frame, bool is2x, bool halfSize);
+		
+		// Items are kept in a heap, so the "greatest" item is the one that
+		// should be loaded first.
+		bool operator<(const Item &other) const;
 		
 		Sprite *sprite;
 		std::string name;
 		std::string path;
-		ImageBuffer *image;
-		Mask *mask;
+		// The item owns whatever has been loaded for it, until it is handed
+		// over to the sprite.
+		std::unique_ptr<ImageBuffer> image;
+		std::unique_ptr<CookedImage> cooked;
+		std::unique_ptr<Mask> mask;
 		int frame;
 		bool is2x;
+		bool halfSize;
+		// Whether a collision mask must be created for this frame.
+		bool needsMask = false;
+		// Which time this sprite has been loaded since it was last unloaded.
+		// Items left over from before an unload are not uploaded.
+		int generation = 0;
+		
+		int priority = NORMAL;
+		// The order in which items with the same priority were added.
+		int64_t sequence = 0;
+		// The size of the image file, for measuring progress.
+		int64_t bytes = 0;
 	};
 	
 	
 private:
-	std::queue<Item> toRead;
+	// Change the priority of any items in the given heap for the given sprite.
+	static void Prioritize(std::vector<Item> &heap, const Sprite *sprite, Priority priority);
+	// Check if the given item was queued before its sprite was last unloaded.
+	// The caller must hold the read mutex.
+	bool IsStale(const Item &item) const;
+	
+	
+private:
+	std::vector<Item> toRead;
 	// We must read the value of "added" in const functions, so this mutex must
 	// be mutable.
 	mutable std::mutex readMutex;
 	std::condition_variable readCondition;
 	int added;
+	int64_t addedBytes = 0;
+	int64_t sequence = 0;
 	std::map<std::string, int> count;
 	std::map<std::string, int> count2x;
+	std::map<const Sprite *, int> generation;
 	
-	mutable std::queue<Item> toLoad;
+	mutable std::vector<Item> toLoad;
 	mutable std::mutex loadMutex;
 	mutable std::condition_variable loadCondition;
 	mutable int completed;
+	mutable int64_t completedBytes = 0;
 	
 	mutable std::queue<std::string> toUnload;
 	
+	int threadCount = 0;
 	std::vector<std::thread> threads;
 };
 
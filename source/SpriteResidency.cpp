@@ -0,0 +1,276 @@
+/* SpriteResidency.cpp
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "SpriteResidency.h"
+
+#include "CookedImage.h"
+#include "ImageBuffer.h"
+#include "Sprite.h"
+#include "SpriteSet.h"
+
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+	// A sprite must go unused for at least this many frames before it can be
+	// unloaded. This keeps sprites that are only drawn now and then (e.g. on
+	// alternate frames) from being reloaded over and over, and makes sure that
+	// no draw list that has not been drawn yet still refers to its textures.
+	const int MIN_UNUSED_FRAMES = 60;
+	
+	// The user interface must be ready as soon as the game starts, and it
+	// should never flicker out while it is being reloaded.
+	bool IsInterface(const string &name)
+	{
+		return (!name.compare(0, 3, "ui/") || !name.compare(0, 6, "_menu/"));
+	}
+	
+	// Ships and asteroids need their collision masks even when they are not
+	// on screen, so they are loaded up front. Their masks are kept when their
+	// textures are unloaded.
+	bool HasMask(const string &name)
+	{
+		return (!name.compare(0, 5, "ship/") || !name.compare(0, 9, "asteroid/"));
+	}
+}
+
+
+
+SpriteResidency::SpriteResidency(SpriteQueue &queue)
+	: queue(queue)
+{
+}
+
+
+
+// Set how many bytes of textures may be loaded at once.
+void SpriteResidency::SetBudget(int64_t bytes)
+{
+	budget = max<int64_t>(0, bytes);
+}
+
+
+
+// Add an image file for the given sprite.
+void SpriteResidency::Add(const string &name, const string &path, bool halfSize)
+{
+	Sprite *sprite = SpriteSet::Modify(name);
+	lock_guard<mutex> lock(entryMutex);
+	Entry &entry = entries[sprite];
+	if(entry.name.empty())
+	{
+		entry.name = name;
+		entry.canUnload = !IsInterface(name);
+		if(!entry.canUnload)
+			entry.priority = SpriteQueue::INTERFACE;
+		if(IsInterface(name) || HasMask(name))
+		{
+			entry.isQueued = true;
+			sprite->isRequested = true;
+		}
+	}
+	entry.paths.emplace_back(path, halfSize);
+	
+	// Full size @2x images are numbered separately from the ordinary frames.
+	bool is2x = SpriteQueue::Is2x(path) && !halfSize;
+	++(is2x ? entry.frames2x : entry.frames);
+	
+	// If the sprite is not loaded or on its way, it will not be loaded until it
+	// is needed, but the game needs to know its size before that.
+	int width = 0;
+	int height = 0;
+	if(!entry.isQueued && !is2x)
+	{
+		bool isValid = SpriteQueue::IsCooked(path) ? CookedImage::ReadSize(path, width, height)
+			: ImageBuffer::ReadSize(path, width, height);
+		if(!isValid)
+			width = height = 0;
+		else if(SpriteQueue::Is2x(path))
+		{
+			width /= 2;
+			height /= 2;
+		}
+	}
+	sprite->Reserve(entry.frames, entry.frames2x, width, height, HasMask(name));
+	
+	// If this sprite is loaded or on its way, load this image along with it.
+	if(entry.isQueued)
+		queue.Add(name, path, entry.priority, halfSize);
+}
+
+
+
+// Load the given sprite if it is not already loaded or queued.
+void SpriteResidency::Load(const Sprite *sprite, SpriteQueue::Priority priority)
+{
+	lock_guard<mutex> lock(entryMutex);
+	DoLoad(sprite, priority);
+}
+
+
+
+// Reload an image file that has been changed.
+bool SpriteResidency::Reload(const string &name, const string &path, const string &previous)
+{
+	lock_guard<mutex> lock(entryMutex);
+	auto it = entries.find(SpriteSet::Get(name));
+	if(it == entries.end())
+		return false;
+	
+	Entry &entry = it->second;
+	auto match = entry.paths.begin();
+	while(match != entry.paths.end() && match->first != path && match->first != previous)
+		++match;
+	if(match == entry.paths.end())
+		return false;
+	
+	// Frames are numbered in the order that their images were added, with the
+	// @2x frames numbered separately from the ordinary ones.
+	bool is2x = SpriteQueue::Is2x(match->first) && !match->second;
+	int frame = 0;
+	for(auto image = entry.paths.begin(); image != match; ++image)
+		frame += ((SpriteQueue::Is2x(image->first) && !image->second) == is2x);
+	
+	match->first = path;
+	if(entry.isQueued)
+		queue.Reload(name, path, frame, match->second);
+	return true;
+}
+
+
+
+// Load any sprites that were drawn without being loaded, upload new textures,
+// and unload the least recently used sprites if over budget.
+void SpriteResidency::Step()
+{
+	int now = Sprite::AdvanceClock();
+	
+	// A sprite that is being drawn is needed right away.
+	vector<const Sprite *> requests = Sprite::TakeRequests();
+	if(!requests.empty())
+	{
+		lock_guard<mutex> lock(entryMutex);
+		for(const Sprite *sprite : requests)
+			DoLoad(sprite, SpriteQueue::IMMEDIATE);
+	}
+	queue.Progress();
+	
+	lock_guard<mutex> lock(entryMutex);
+	int64_t total = 0;
+	for(const auto &it : entries)
+		total += it.first->textureBytes;
+	peakBytes = max(peakBytes, total);
+	if(!budget || total <= budget)
+		return;
+	
+	// Find all the sprites that could be unloaded, and unload the ones that
+	// have gone unused the longest until the total is within the budget.
+	vector<pair<int, const Sprite *>> unused;
+	for(const auto &it : entries)
+		if(it.second.canUnload && it.second.isQueued && it.first->textureBytes
+				&& now - it.first->lastUse > MIN_UNUSED_FRAMES)
+			unused.emplace_back(it.first->lastUse, it.first);
+	sort(unused.begin(), unused.end());
+	
+	for(const pair<int, const Sprite *> &it : unused)
+	{
+		if(total <= budget)
+			break;
+		
+		Entry &entry = entries[it.second];
+		int64_t bytes = it.second->textureBytes;
+		queue.Unload(entry.name);
+		entry.isQueued = false;
+		entry.priority = SpriteQueue::NORMAL;
+		total -= bytes;
+		
+		++unloadCount;
+		unloadedBytes += bytes;
+	}
+}
+
+
+
+// Print a table of how many sprites are loaded, and how much memory they use.
+void SpriteResidency::PrintReport() const
+{
+	lock_guard<mutex> lock(entryMutex);
+	
+	// Sprites are grouped by the first part of their names, e.g. "ship".
+	class Category {
+	public:
+		size_t loaded = 0;
+		size_t waiting = 0;
+		int64_t textureBytes = 0;
+		int64_t maskBytes = 0;
+	};
+	map<string, Category> categories;
+	Category total;
+	for(const auto &it : entries)
+	{
+		const Sprite &sprite = *it.first;
+		Category &category = categories[it.second.name.substr(0, it.second.name.find('/'))];
+		int64_t maskBytes = 0;
+		for(const Mask &mask : sprite.masks)
+			maskBytes += mask.Bytes();
+		for(Category *c : {&category, &total})
+		{
+			++(sprite.textureBytes ? c->loaded : c->waiting);
+			c->textureBytes += sprite.textureBytes;
+			c->maskBytes += maskBytes;
+		}
+	}
+	
+	cout << "sprites" << '\t' << "loaded" << '\t' << "not loaded" << '\t' << "texture bytes" << '\t' << "mask bytes" << '\n';
+	for(const auto &it : categories)
+		cout << it.first << '\t' << it.second.loaded << '\t' << it.second.waiting
+			<< '\t' << it.second.textureBytes << '\t' << it.second.maskBytes << '\n';
+	cout << "total" << '\t' << total.loaded << '\t' << total.waiting
+		<< '\t' << total.textureBytes << '\t' << total.maskBytes << '\n';
+	cout << "peak loaded" << '\t' << '\t' << '\t' << peakBytes << '\n';
+	cout << "budget" << '\t' << '\t' << '\t' << budget << '\n';
+	cout << "loaded on demand" << '\t' << loadCount << '\n';
+	cout << "unloaded" << '\t' << unloadCount << '\t' << '\t' << unloadedBytes << '\n';
+	cout.flush();
+}
+
+
+
+// Load the given sprite. The caller must hold the mutex.
+void SpriteResidency::DoLoad(const Sprite *sprite, SpriteQueue::Priority priority)
+{
+	auto it = entries.find(sprite);
+	if(it == entries.end())
+		return;
+	
+	Entry &entry = it->second;
+	sprite->isRequested = true;
+	if(entry.isQueued)
+	{
+		// If any of this sprite's images are still waiting to be loaded, move
+		// them to the front of the line.
+		if(priority < entry.priority)
+		{
+			entry.priority = priority;
+			queue.Prioritize(sprite, priority);
+		}
+		return;
+	}
+	
+	entry.isQueued = true;
+	entry.priority = priority;
+	for(const pair<string, bool> &path : entry.paths)
+		queue.Add(entry.name, path.first, priority, path.second);
+	++loadCount;
+}
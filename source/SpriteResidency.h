@@ -0,0 +1,107 @@
+/* SpriteResidency.h
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef SPRITE_RESIDENCY_H_
+#define SPRITE_RESIDENCY_H_
+
+#include "SpriteQueue.h"
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+class Sprite;
+
+
+
+// Class which decides which sprites have their textures loaded. Sprites that
+// the game needs up front (the user interface, and anything with a collision
+// mask) are queued as soon as their images are added. Everything else is only
+// loaded once it is drawn or preloaded; until then it draws as nothing, but
+// its size is known from its image files. If the textures that are loaded add
+// up to more than the memory budget, the ones that have gone unused the
+// longest are unloaded again, and will be reloaded if they are drawn.
+class SpriteResidency {
+public:
+	explicit SpriteResidency(SpriteQueue &queue);
+	
+	// Set how many bytes of textures may be loaded at once. Zero means that
+	// there is no limit.
+	void SetBudget(int64_t bytes);
+	
+	// Add an image file for the given sprite. If halfSize is set, the image is
+	// an @2x image that stands in for a missing @1x image.
+	void Add(const std::string &name, const std::string &path, bool halfSize);
+	// Load the given sprite if it is not already loaded or queued, or if it is
+	// queued, move it up to the given priority. This may be called from any
+	// thread.
+	void Load(const Sprite *sprite, SpriteQueue::Priority priority);
+	
+	// Reload an image file that has been changed. The previous path is the
+	// file that the image was loaded from before, e.g. a cooked texture that
+	// is now out of date. If the sprite is loaded, its frame is replaced as
+	// soon as the new image has been read. This returns false if the image is
+	// not part of any sprite yet.
+	bool Reload(const std::string &name, const std::string &path, const std::string &previous);
+	
+	// Load any sprites that were drawn without being loaded, upload whatever
+	// textures have been read since the last frame, and unload the least
+	// recently used sprites if over budget. This must be called once per frame,
+	// from the main thread, while the game's calculation thread is idle.
+	void Step();
+	
+	// Print a table of how many sprites are loaded, and how much memory they use.
+	void PrintReport() const;
+	
+	
+private:
+	// Load the given sprite. The caller must hold the mutex.
+	void DoLoad(const Sprite *sprite, SpriteQueue::Priority priority);
+	
+	
+private:
+	class Entry {
+	public:
+		std::string name;
+		// Each image file, and whether to load it at half size.
+		std::vector<std::pair<std::string, bool>> paths;
+		// The number of ordinary and @2x frames.
+		int frames = 0;
+		int frames2x = 0;
+		SpriteQueue::Priority priority = SpriteQueue::NORMAL;
+		// Whether the sprite's images have been queued since it was last unloaded.
+		bool isQueued = false;
+		// Whether the sprite can be unloaded if it is not being used.
+		bool canUnload = true;
+	};
+	
+	
+private:
+	SpriteQueue &queue;
+	// Sprites may be preloaded from the game's calculation thread.
+	mutable std::mutex entryMutex;
+	std::map<const Sprite *, Entry> entries;
+	int64_t budget = 0;
+	
+	// Statistics for the memory report.
+	int loadCount = 0;
+	int unloadCount = 0;
+	int64_t unloadedBytes = 0;
+	int64_t peakBytes = 0;
+};
+
+
+
+#endif
@@ -15,23 +15,71 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Sprite.h"
 
 #include <map>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace std;
 
 namespace {
 	map<string, Sprite> sprites;
+	// Hash index for faster lookups. The map above owns the sprites.
+	unordered_map<string, Sprite *> index;
+	// Sprites that SpriteQueue has been asked to load images for.
+	unordered_set<string> defined;
+	// Sprites can be looked up from any thread, and new ones are added while
+	// the game is running (e.g. by SpriteResidency), so adding one to the hash
+	// index could otherwise rehash it in the middle of another thread's lookup.
+	// Code that needs a sprite every frame should use a Handle instead.
+	mutex spriteMutex;
+	
+	Sprite *Find(const string &name)
+	{
+		lock_guard<mutex> lock(spriteMutex);
+		auto it = index.find(name);
+		if(it != index.end())
+			return it->second;
+		
+		Sprite *sprite = &sprites[name];
+		index[name] = sprite;
+		return sprite;
+	}
 }
 
 
 
 const Sprite *SpriteSet::Get(const string &name)
 {
-	return &sprites[name];
+	return Find(name);
+}
+
+
+
+Handle<Sprite> SpriteSet::GetHandle(const string &name)
+{
+	return Handle<Sprite>(Find(name));
+}
+
+
+
+// Get the names of all sprites that were looked up but never given images.
+vector<string> SpriteSet::Undefined()
+{
+	lock_guard<mutex> lock(spriteMutex);
+	vector<string> names;
+	for(const auto &it : sprites)
+		if(!defined.count(it.first))
+			names.push_back(it.first);
+	return names;
 }
 
 
 
 Sprite *SpriteSet::Modify(const string &name)
 {
-	return &sprites[name];
+	{
+		lock_guard<mutex> lock(spriteMutex);
+		defined.insert(name);
+	}
+	return Find(name);
 }
@@ -13,7 +13,10 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef SPRITE_SET_H_
 #define SPRITE_SET_H_
 
+#include "Handle.h"
+
 #include <string>
+#include <vector>
 
 class Sprite;
 
@@ -22,14 +25,20 @@ class Sprite;
 // Class for storing sprites, and for getting the sprite associated with a given
 // name. If a sprite has not been loaded yet, this will still return an object
 // but with no OpenGL textures associated with it (so it will draw nothing).
+// Code that draws the same sprite every frame should keep a Handle to it.
 class SpriteSet {
 public:
 	static const Sprite *Get(const std::string &name);
+	static Handle<Sprite> GetHandle(const std::string &name);
+	
+	// Get the names of all sprites that were looked up but never given images.
+	static std::vector<std::string> Undefined();
 	
 	
 private:
-	// Only SpriteQueue is allowed to modify the sprites.
+	// Only SpriteQueue and SpriteResidency are allowed to modify the sprites.
 	friend class SpriteQueue;
+	friend class SpriteResidency;
 	static Sprite *Modify(const std::string &name);
 };
 
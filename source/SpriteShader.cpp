@@ -17,20 +17,36 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Shader.h"
 #include "Sprite.h"
 
+#include <cstddef>
+
 using namespace std;
 
 namespace {
 	Shader shader;
 	GLint scaleI;
-	GLint transformI;
-	GLint positionI;
-	GLint blurI;
-	GLint clipI;
-	GLint fadeI;
+	GLint swizzleMatrixI;
+	
+	GLint vertA;
+	GLint positionA;
+	GLint transformA;
+	GLint blurA;
+	GLint clipA;
+	GLint fadeA;
+	GLint swizzleA;
+	GLint rect0A;
+	GLint rect1A;
 	
 	GLuint vao;
 	GLuint vbo;
-
+	
+	// If instanced drawing is supported, this vertex array pulls the per-sprite
+	// attributes out of the instance buffer instead of using constant values.
+	bool useInstancing = false;
+	GLuint instanceVao;
+	GLuint instanceVbo;
+	
+	// Each swizzle lists which source channel is used for each of the output
+	// red, green, blue, and alpha channels.
 	static const GLint SWIZZLE[9][4] = {
 		{GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA}, // red + yellow markings (republic)
 		{GL_RED, GL_BLUE, GL_GREEN, GL_ALPHA}, // red + magenta markings
@@ -42,6 +58,31 @@ namespace {
 		{GL_BLUE, GL_ZERO, GL_ZERO, GL_ALPHA},  // red only (cloaked)
 		{GL_ZERO, GL_ZERO, GL_ZERO, GL_ALPHA}  // black only (outline)
 	};
+	static const int SWIZZLE_COUNT = sizeof(SWIZZLE) / sizeof(SWIZZLE[0]);
+	
+	// Set up the given per-sprite attribute to be read from the instance buffer.
+	void InstanceAttrib(GLint attrib, int size, size_t offset)
+	{
+		if(attrib < 0)
+			return;
+		glEnableVertexAttribArray(attrib);
+		glVertexAttribPointer(attrib, size, GL_FLOAT, GL_FALSE,
+			sizeof(SpriteShader::Instance), reinterpret_cast<const GLvoid *>(offset));
+		glVertexAttribDivisor(attrib, 1);
+	}
+	
+	// Set a per-sprite attribute to a constant value, for non-instanced drawing.
+	void ConstantAttrib(GLint attrib, int size, const float *value)
+	{
+		if(attrib < 0)
+			return;
+		if(size == 1)
+			glVertexAttrib1f(attrib, *value);
+		else if(size == 2)
+			glVertexAttrib2fv(attrib, value);
+		else
+			glVertexAttrib4fv(attrib, value);
+	}
 }
 
 
@@ -49,67 +90,119 @@ namespace {
 // Initialize the shaders.
 void SpriteShader::Init()
 {
+	// The color swizzle used to be done by setting texture parameters. Instead,
+	// it is now done in the shader, so that sprites with different swizzles can
+	// be drawn in the same batch.
 	static const char *vertexCode =
-		"uniform mat2 transform;\n"
-		"uniform vec2 position;\n"
 		"uniform vec2 scale;\n"
-		"uniform vec2 blur;\n"
-		"uniform float clip;\n"
 		
 		"in vec2 vert;\n"
+		"in vec2 position;\n"
+		"in vec4 transform;\n"
+		"in vec2 blur;\n"
+		"in float clip;\n"
+		"in float fade;\n"
+		"in float swizzle;\n"
+		"in vec4 rect0;\n"
+		"in vec4 rect1;\n"
+		
 		"out vec2 fragTexCoord;\n"
+		"flat out vec2 fragBlur;\n"
+		"flat out float fragFade;\n"
+		"flat out int fragSwizzle;\n"
+		"flat out vec4 fragRect0;\n"
+		"flat out vec4 fragRect1;\n"
 		
 		"void main() {\n"
 		"  vec2 blurOff = 2 * vec2(vert.x * abs(blur.x), vert.y * abs(blur.y));\n"
-		"  gl_Position = vec4((transform * (vert + blurOff) + position) * scale, 0, 1);\n"
+		"  mat2 matrix = mat2(transform.xy, transform.zw);\n"
+		"  gl_Position = vec4((matrix * (vert + blurOff) + position) * scale, 0, 1);\n"
 		"  vec2 texCoord = vert + vec2(.5, .5);\n"
-		"  fragTexCoord = vec2(texCoord.x, max(clip, texCoord.y)) + blurOff;\n"
+		"  fragTexCoord = vec2(texCoord.x, max(1. - clip, texCoord.y)) + blurOff;\n"
+		"  fragBlur = blur;\n"
+		"  fragFade = fade;\n"
+		"  fragSwizzle = int(swizzle + .5);\n"
+		"  fragRect0 = rect0;\n"
+		"  fragRect1 = rect1;\n"
 		"}\n";
 
+	// The texture coordinates are relative to the frame being drawn, and must
+	// be mapped to the part of the texture that holds that frame. They are
+	// clamped to that part of the texture, just like GL_CLAMP_TO_EDGE would do
+	// for a frame that has a texture all to itself.
 	static const char *fragmentCode =
 		"uniform sampler2D tex0;\n"
 		"uniform sampler2D tex1;\n"
-		"uniform float fade;\n"
-		"uniform vec2 blur;\n"
+		"uniform mat4 swizzleMatrix[9];\n"
 		"const int range = 5;\n"
 		
 		"in vec2 fragTexCoord;\n"
+		"flat in vec2 fragBlur;\n"
+		"flat in float fragFade;\n"
+		"flat in int fragSwizzle;\n"
+		"flat in vec4 fragRect0;\n"
+		"flat in vec4 fragRect1;\n"
 		"out vec4 finalColor;\n"
 		
+		"vec4 sampleRect(sampler2D tex, vec4 rect, vec2 coord) {\n"
+		"  vec2 halfTexel = .5 / vec2(textureSize(tex, 0));\n"
+		"  vec2 atlasCoord = clamp(rect.xy + coord * rect.zw, rect.xy + halfTexel, rect.xy + rect.zw - halfTexel);\n"
+		"  return texture(tex, atlasCoord);\n"
+		"}\n"
+		
+		"vec4 sampleFrame(vec2 coord) {\n"
+		"  vec4 color = sampleRect(tex0, fragRect0, coord);\n"
+		"  if(fragFade != 0)\n"
+		"    color = mix(color, sampleRect(tex1, fragRect1, coord), fragFade);\n"
+		"  return color;\n"
+		"}\n"
+		
 		"void main() {\n"
-		"  if(blur.x == 0 && blur.y == 0)\n"
+		"  vec4 color;\n"
+		"  if(fragBlur.x == 0 && fragBlur.y == 0)\n"
+		"    color = sampleFrame(fragTexCoord);\n"
+		"  else\n"
 		"  {\n"
-		"    if(fade != 0)\n"
-		"     finalColor = mix(texture(tex0, fragTexCoord), texture(tex1, fragTexCoord), fade);\n"
-		"    else\n"
-		"      finalColor = texture(tex0, fragTexCoord);\n"
-		"    return;\n"
+		"    const float divisor = range * (range + 2) + 1;\n"
+		"    color = vec4(0., 0., 0., 0.);\n"
+		"    for(int i = -range; i <= range; ++i)\n"
+		"    {\n"
+		"      float scale = (range + 1 - abs(i)) / divisor;\n"
+		"      color += scale * sampleFrame(fragTexCoord + (fragBlur * i) / range);\n"
+		"    }\n"
 		"  }\n"
-		"  const float divisor = range * (range + 2) + 1;\n"
-		"  vec4 color = vec4(0., 0., 0., 0.);\n"
-		"  for(int i = -range; i <= range; ++i)\n"
-		"  {\n"
-		"    float scale = (range + 1 - abs(i)) / divisor;\n"
-		"    vec2 coord = fragTexCoord + (blur * i) / range;\n"
-		"    if(fade != 0)\n"
-		"      color += scale * mix(texture(tex0, coord), texture(tex1, coord), fade);\n"
-		"    else\n"
-		"      color += scale * texture(tex0, coord);\n"
-		"  }\n"
-		"  finalColor = color;\n"
+		"  finalColor = swizzleMatrix[fragSwizzle] * color;\n"
 		"}\n";
 	
 	shader = Shader(vertexCode, fragmentCode);
 	scaleI = shader.Uniform("scale");
-	transformI = shader.Uniform("transform");
-	positionI = shader.Uniform("position");
-	blurI = shader.Uniform("blur");
-	clipI = shader.Uniform("clip");
-	fadeI = shader.Uniform("fade");
+	swizzleMatrixI = shader.Uniform("swizzleMatrix");
+	
+	vertA = shader.Attrib("vert");
+	positionA = shader.Attrib("position");
+	transformA = shader.Attrib("transform");
+	blurA = shader.Attrib("blur");
+	clipA = shader.Attrib("clip");
+	fadeA = shader.Attrib("fade");
+	swizzleA = shader.Attrib("swizzle");
+	rect0A = shader.Attrib("rect0");
+	rect1A = shader.Attrib("rect1");
+	
+	// Convert the swizzle table into color matrices. The matrices are stored
+	// in column-major order, so column i holds the output for input channel i.
+	GLfloat matrices[SWIZZLE_COUNT][16] = {};
+	for(int s = 0; s < SWIZZLE_COUNT; ++s)
+		for(int out = 0; out < 4; ++out)
+		{
+			GLint channel = SWIZZLE[s][out];
+			if(channel >= GL_RED && channel <= GL_ALPHA)
+				matrices[s][(channel - GL_RED) * 4 + out] = 1.f;
+		}
 	
 	glUseProgram(shader.Object());
 	glUniform1i(shader.Uniform("tex0"), 0);
 	glUniform1i(shader.Uniform("tex1"), 1);
+	glUniformMatrix4fv(swizzleMatrixI, SWIZZLE_COUNT, GL_FALSE, &matrices[0][0]);
 	glUseProgram(0);
 	
 	// Generate the vertex data for drawing sprites.
@@ -127,10 +220,37 @@ void SpriteShader::Init()
 	};
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertexData), vertexData, GL_STATIC_DRAW);
 	
-	glEnableVertexAttribArray(shader.Attrib("vert"));
-	glVertexAttribPointer(shader.Attrib("vert"), 2, GL_FLOAT, GL_FALSE,
+	glEnableVertexAttribArray(vertA);
+	glVertexAttribPointer(vertA, 2, GL_FLOAT, GL_FALSE,
 		2 * sizeof(GLfloat), NULL);
 	
+	// Instanced vertex attributes require OpenGL 3.3.
+	GLint major = 0;
+	GLint minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	useInstancing = (major > 3 || (major == 3 && minor >= 3));
+	if(useInstancing)
+	{
+		glGenVertexArrays(1, &instanceVao);
+		glBindVertexArray(instanceVao);
+		
+		glEnableVertexAttribArray(vertA);
+		glVertexAttribPointer(vertA, 2, GL_FLOAT, GL_FALSE,
+			2 * sizeof(GLfloat), NULL);
+		
+		glGenBuffers(1, &instanceVbo);
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+		InstanceAttrib(positionA, 2, offsetof(Instance, position));
+		InstanceAttrib(transformA, 4, offsetof(Instance, transform));
+		InstanceAttrib(blurA, 2, offsetof(Instance, blur));
+		InstanceAttrib(clipA, 1, offsetof(Instance, clip));
+		InstanceAttrib(fadeA, 1, offsetof(Instance, fade));
+		InstanceAttrib(swizzleA, 1, offsetof(Instance, swizzle));
+		InstanceAttrib(rect0A, 4, offsetof(Instance, rect0));
+		InstanceAttrib(rect1A, 4, offsetof(Instance, rect1));
+	}
+	
 	// unbind the VBO and VAO
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
@@ -143,12 +263,23 @@ void SpriteShader::Draw(const Sprite *sprite, const Point &position, float zoom,
 	if(!sprite)
 		return;
 	
-	float pos[2] = {
-		static_cast<float>(position.X()), static_cast<float>(position.Y())};
-	float trans[4] = {sprite->Width() * zoom, 0.f, 0.f, sprite->Height() * zoom};
+	const Sprite::Region &region = sprite->GetRegion();
+	if(!region.texture)
+		return;
+	
+	Instance instance = {
+		{static_cast<float>(position.X()), static_cast<float>(position.Y())},
+		{sprite->Width() * zoom, 0.f, 0.f, sprite->Height() * zoom},
+		{0.f, 0.f},
+		1.f,
+		0.f,
+		static_cast<float>(swizzle),
+		{region.rect[0], region.rect[1], region.rect[2], region.rect[3]},
+		{0.f, 0.f, 1.f, 1.f}
+	};
 	
 	Bind();
-	Add(sprite->Texture(), 0, pos, trans, swizzle, 1.f, 0.f);
+	Add(region.texture, 0, &instance, 1);
 	Unbind();
 }
 
@@ -166,32 +297,53 @@ void SpriteShader::Bind()
 
 
 
-void SpriteShader::Add(uint32_t tex0, uint32_t tex1, const float position[2], const float transform[4], int swizzle, float clip, float fade, const float blur[2])
+// Draw any number of sprites that all use the same textures. If instanced
+// drawing is not supported, this falls back to drawing them one at a time.
+void SpriteShader::Add(uint32_t tex0, uint32_t tex1, const Instance *instances, int count)
 {
-	glUniformMatrix2fv(transformI, 1, false, transform);
-	glUniform2fv(positionI, 1, position);
-	glBindTexture(GL_TEXTURE_2D, tex0);
+	if(count <= 0)
+		return;
 	
-	if(fade && tex1)
+	glBindTexture(GL_TEXTURE_2D, tex0);
+	if(tex1)
 	{
 		glActiveTexture(GL_TEXTURE1);
 		glBindTexture(GL_TEXTURE_2D, tex1);
-		glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, SWIZZLE[swizzle]);
 		glActiveTexture(GL_TEXTURE0);
 	}
-	else
-		fade = 0.f;
 	
-	// Set the color swizzle.
-	glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, SWIZZLE[swizzle]);
+	if(!useInstancing)
+	{
+		// Draw each sprite separately, passing its parameters as constant
+		// vertex attributes.
+		for(int i = 0; i < count; ++i)
+		{
+			const Instance &it = instances[i];
+			float fade = tex1 ? it.fade : 0.f;
+			ConstantAttrib(positionA, 2, it.position);
+			ConstantAttrib(transformA, 4, it.transform);
+			ConstantAttrib(blurA, 2, it.blur);
+			ConstantAttrib(clipA, 1, &it.clip);
+			ConstantAttrib(fadeA, 1, &fade);
+			ConstantAttrib(swizzleA, 1, &it.swizzle);
+			ConstantAttrib(rect0A, 4, it.rect0);
+			ConstantAttrib(rect1A, 4, it.rect1);
+			
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		}
+		return;
+	}
+	
+	// Orphan the previous contents of the instance buffer, so that the driver
+	// does not have to wait for earlier draw calls that are still using it.
+	glBindVertexArray(instanceVao);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+	glBufferData(GL_ARRAY_BUFFER, count * sizeof(Instance), instances, GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	
-	// Set the clipping.
-	glUniform1f(clipI, 1.f - clip);
-	glUniform1f(fadeI, fade);
-	const float noBlur[2] = {0.f, 0.f};
-	glUniform2fv(blurI, 1, blur ? blur : noBlur);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
 	
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	glBindVertexArray(vao);
 }
 
 
@@ -26,6 +26,33 @@ class Point;
 // most often just for use by the DrawList class, which calculates those input
 // parameters based on an object's rotation, animation frame, etc.
 class SpriteShader {
+public:
+	// The parameters for drawing one sprite. When many sprites share the same
+	// textures, an array of these is uploaded to the GPU all at once and the
+	// sprites are drawn with a single (instanced) draw call.
+	class Instance {
+	public:
+		// The (x, y) position of the center of the sprite.
+		float position[2];
+		// The [a, b; c, d] size and rotation matrix.
+		float transform[4];
+		// The blur vector, in texture space.
+		float blur[2];
+		// The fraction of the sprite's height to draw.
+		float clip;
+		// How far to fade from the first texture to the second.
+		float fade;
+		// The color swizzle (stored as a float so that it can be uploaded along
+		// with the other attributes).
+		float swizzle;
+		// The part of each of the two textures to draw, as (x, y, width, height)
+		// in texture coordinates. This allows frames stored in a shared atlas
+		// texture to be drawn.
+		float rect0[4];
+		float rect1[4];
+	};
+	
+	
 public:
 	// Initialize the shaders.
 	static void Init();
@@ -34,7 +61,9 @@ public:
 	static void Draw(const Sprite *sprite, const Point &position, float zoom = 1., int swizzle = 0);
 	
 	static void Bind();
-	static void Add(uint32_t tex0, uint32_t tex1, const float position[2], const float transform[4], int swizzle = 0, float clip = 1., float fade = 0., const float blur[2] = nullptr);
+	// Draw any number of sprites that all use the same textures. If instanced
+	// drawing is not supported, this falls back to drawing them one at a time.
+	static void Add(uint32_t tex0, uint32_t tex1, const Instance *instances, int count);
 	static void Unbind();
 };
 
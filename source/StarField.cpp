@@ -14,17 +14,34 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "pi.h"
 #include "Point.h"
+#include "Preferences.h"
 #include "Random.h"
 #include "Screen.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <numeric>
+#include <string>
 
 using namespace std;
 
 namespace {
 	static const int TILE_SIZE = 256;
+	// Above this many square pixels of visible star field, draw fewer stars so
+	// that the total number drawn stays about the same.
+	static const double FULL_DENSITY_AREA = 2560. * 1600.;
+	
+	// The star field shaders differ only in how they find each star's data.
+	static const char *fragmentCode =
+		"in float fragmentAlpha;\n"
+		"in vec2 coord;\n"
+		"out vec4 finalColor;\n"
+		
+		"void main() {\n"
+		"  float alpha = fragmentAlpha * (1. - abs(coord.x) - abs(coord.y));\n"
+		"  finalColor = vec4(1, 1, 1, 1) * alpha;\n"
+		"}\n";
 }
 
 
@@ -39,21 +56,13 @@ void StarField::Init(int stars, int width)
 
 void StarField::Draw(const Point &pos, const Point &vel) const
 {
-	glUseProgram(shader.Object());
-	glBindVertexArray(vao);
-	
 	float length = vel.Length();
 	Point unit = length ? vel.Unit() : Point(1., 0.);
 	
 	GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
-	glUniform2fv(scaleI, 1, scale);
-	
 	GLfloat rotate[4] = {
 		static_cast<float>(unit.Y()), static_cast<float>(-unit.X()),
 		static_cast<float>(unit.X()), static_cast<float>(unit.Y())};
-	glUniformMatrix2fv(rotateI, 1, false, rotate);
-	
-	glUniform1f(lengthI, length);
 	
 	// Stars this far beyond the border may still overlap the screen.
 	double borderX = fabs(vel.X()) + 1.;
@@ -63,10 +72,60 @@ void StarField::Draw(const Point &pos, const Point &vel) const
 	long minY = Screen::Top() + pos.Y() - borderY;
 	long maxX = Screen::Right() + pos.X() + borderX;
 	long maxY = Screen::Bottom() + pos.Y() + borderY;
+	double density = Density(static_cast<double>(maxX - minX) * (maxY - minY));
 	// Round down to the start of the nearest tile.
 	minX &= ~(TILE_SIZE - 1l);
 	minY &= ~(TILE_SIZE - 1l);
 	
+	if(useInstancing)
+	{
+		glUseProgram(instancedShader.Object());
+		glBindVertexArray(instancedVao);
+		
+		glUniform2fv(instancedScaleI, 1, scale);
+		glUniformMatrix2fv(instancedRotateI, 1, false, rotate);
+		glUniform1f(instancedLengthI, length);
+		glUniform1f(densityI, density);
+		
+		// The vertex shader figures out which tile each instance is drawing.
+		int columns = (maxX - minX + TILE_SIZE - 1) / TILE_SIZE;
+		int rows = (maxY - minY + TILE_SIZE - 1) / TILE_SIZE;
+		glUniform2i(firstTileI, (minX & widthMod) / TILE_SIZE, (minY & widthMod) / TILE_SIZE);
+		glUniform1i(columnsI, columns);
+		
+		Point off = Point(minX, minY) - pos;
+		GLfloat translate[2] = {
+			static_cast<float>(off.X()),
+			static_cast<float>(off.Y())
+		};
+		glUniform2fv(instancedTranslateI, 1, translate);
+		
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_BUFFER, starTexture);
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_BUFFER, tileTexture);
+		
+		// Every instance draws enough vertices for the most crowded tile. The
+		// extra ones in sparser tiles are discarded by the vertex shader.
+		int vertices = 6 * static_cast<int>(ceil(maxTileStars * density));
+		glDrawArraysInstanced(GL_TRIANGLES, 0, vertices, columns * rows);
+		
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+		
+		glBindVertexArray(0);
+		glUseProgram(0);
+		return;
+	}
+	
+	glUseProgram(shader.Object());
+	glBindVertexArray(vao);
+	
+	glUniform2fv(scaleI, 1, scale);
+	glUniformMatrix2fv(rotateI, 1, false, rotate);
+	glUniform1f(lengthI, length);
+	
 	for(long gy = minY; gy < maxY; gy += TILE_SIZE)
 		for(long gx = minX; gx < maxX; gx += TILE_SIZE)
 		{
@@ -79,7 +138,7 @@ void StarField::Draw(const Point &pos, const Point &vel) const
 			
 			int index = (gx & widthMod) / TILE_SIZE + ((gy & widthMod) / TILE_SIZE) * tileCols;
 			int first = 6 * tileIndex[index];
-			int count = 6 * tileIndex[index + 1] - first;
+			int count = 6 * static_cast<int>((tileIndex[index + 1] - tileIndex[index]) * density);
 			glDrawArrays(GL_TRIANGLES, first, count);
 		}
 	
@@ -109,16 +168,6 @@ void StarField::SetUpGraphics()
 		"  vec2 elongated = vec2(coord.x * size, coord.y * (size + elongation));\n"
 		"  gl_Position = vec4((rotate * elongated + translate + offset) * scale, 0, 1);\n"
 		"}\n";
-
-	static const char *fragmentCode =
-		"in float fragmentAlpha;\n"
-		"in vec2 coord;\n"
-		"out vec4 finalColor;\n"
-		
-		"void main() {\n"
-		"  float alpha = fragmentAlpha * (1. - abs(coord.x) - abs(coord.y));\n"
-		"  finalColor = vec4(1, 1, 1, 1) * alpha;\n"
-		"}\n";
 	
 	shader = Shader(vertexCode, fragmentCode);
 	
@@ -138,6 +187,87 @@ void StarField::SetUpGraphics()
 	rotateI = shader.Uniform("rotate");
 	lengthI = shader.Uniform("elongation");
 	translateI = shader.Uniform("translate");
+	
+	// Buffer textures and instanced drawing require OpenGL 3.1.
+	GLint major = 0;
+	GLint minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	useInstancing = (major > 3 || (major == 3 && minor >= 1));
+	if(!useInstancing)
+		return;
+	
+	// Each instance is one tile. The star data is read from the same buffer as
+	// above, which holds six vertices of (x, y, size, corner) for each star.
+	static const string instancedCode =
+		"uniform samplerBuffer stars;\n"
+		"uniform isamplerBuffer tiles;\n"
+		"uniform mat2 rotate;\n"
+		"uniform vec2 translate;\n"
+		"uniform vec2 scale;\n"
+		"uniform float elongation;\n"
+		"uniform ivec2 firstTile;\n"
+		"uniform int columns;\n"
+		"uniform int patternColumns;\n"
+		"uniform float density;\n"
+		
+		"out float fragmentAlpha;\n"
+		"out vec2 coord;\n"
+		
+		"void main() {\n"
+		"  ivec2 tile = ivec2(gl_InstanceID % columns, gl_InstanceID / columns);\n"
+		"  ivec2 wrapped = (firstTile + tile) & ivec2(patternColumns - 1);\n"
+		"  int index = wrapped.x + wrapped.y * patternColumns;\n"
+		"  int first = texelFetch(tiles, index).r;\n"
+		"  int count = int((texelFetch(tiles, index + 1).r - first) * density);\n"
+		"  if(gl_VertexID >= 6 * count) {\n"
+		"    fragmentAlpha = 0.;\n"
+		"    coord = vec2(0, 0);\n"
+		"    gl_Position = vec4(0, 0, 0, 1);\n"
+		"    return;\n"
+		"  }\n"
+		"  vec4 star = texelFetch(stars, 6 * first + gl_VertexID);\n"
+		"  float size = star.z;\n"
+		"  fragmentAlpha = (4. / (4. + elongation)) * size * .2 + .05;\n"
+		"  coord = vec2(sin(star.w), cos(star.w));\n"
+		"  vec2 elongated = vec2(coord.x * size, coord.y * (size + elongation));\n"
+		"  vec2 offset = star.xy + vec2(tile * " + to_string(TILE_SIZE) + ");\n"
+		"  gl_Position = vec4((rotate * elongated + translate + offset) * scale, 0, 1);\n"
+		"}\n";
+	
+	instancedShader = Shader(instancedCode.c_str(), fragmentCode);
+	glUseProgram(instancedShader.Object());
+	glUniform1i(instancedShader.Uniform("stars"), 0);
+	glUniform1i(instancedShader.Uniform("tiles"), 1);
+	glUseProgram(0);
+	
+	instancedScaleI = instancedShader.Uniform("scale");
+	instancedRotateI = instancedShader.Uniform("rotate");
+	instancedLengthI = instancedShader.Uniform("elongation");
+	instancedTranslateI = instancedShader.Uniform("translate");
+	firstTileI = instancedShader.Uniform("firstTile");
+	columnsI = instancedShader.Uniform("columns");
+	densityI = instancedShader.Uniform("density");
+	patternColumnsI = instancedShader.Uniform("patternColumns");
+	
+	// The instanced shader has no vertex attributes, but a VAO must still be
+	// bound in order to draw.
+	glGenVertexArrays(1, &instancedVao);
+	glGenBuffers(1, &tileVbo);
+	glGenTextures(1, &starTexture);
+	glGenTextures(1, &tileTexture);
+}
+
+
+
+// Get the fraction of the stars in each tile that should be drawn, given the
+// area of the star field that is visible.
+double StarField::Density(double area) const
+{
+	double density = min(1., FULL_DENSITY_AREA / max(1., area));
+	if(Preferences::Has("Reduced star field"))
+		density *= .5;
+	return density;
 }
 
 
@@ -192,6 +322,17 @@ void StarField::MakeStars(int stars, int width)
 		++tileIndex[index];
 	}
 	
+	// Shuffle the stars, so that the order of the stars within each tile is
+	// random. Then drawing only the first few stars in each tile (to reduce the
+	// density) will still give an even spread of stars.
+	for(int i = stars - 1; i > 0; --i)
+	{
+		int j = Random::Int(i + 1);
+		swap(temp[2 * i], temp[2 * j]);
+		swap(temp[2 * i + 1], temp[2 * j + 1]);
+	}
+	maxTileStars = *max_element(tileIndex.begin(), tileIndex.end());
+	
 	// Accumulate item counts so that tileIndex[i] is the index in the array of
 	// the first star that falls within tile i, and tileIndex.back() == stars.
 	tileIndex.insert(tileIndex.begin(), 0);
@@ -252,4 +393,22 @@ void StarField::MakeStars(int stars, int width)
 	// unbind the VBO and VAO
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
+	
+	if(useInstancing)
+	{
+		// Expose the star vertices and the tile index to the instanced shader.
+		glBindBuffer(GL_TEXTURE_BUFFER, tileVbo);
+		glBufferData(GL_TEXTURE_BUFFER, sizeof(tileIndex.front()) * tileIndex.size(), tileIndex.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+		
+		glBindTexture(GL_TEXTURE_BUFFER, starTexture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, vbo);
+		glBindTexture(GL_TEXTURE_BUFFER, tileTexture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_R32I, tileVbo);
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+		
+		glUseProgram(instancedShader.Object());
+		glUniform1i(patternColumnsI, tileCols);
+		glUseProgram(0);
+	}
 }
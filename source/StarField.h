@@ -28,7 +28,9 @@ class Point;
 // so that some parts will be much denser than others, which is visually more
 // interesting than if the stars were evenly spread out in perfectly random
 // noise. If the view is moving, the stars are elongated in a motion blur to
-// match the motion; otherwise they would seem to jitter around.
+// match the motion; otherwise they would seem to jitter around. The stars are
+// thinned out when the visible area is very large (e.g. on 4K screens or at
+// high speeds), and further if the "Reduced star field" preference is set.
 class StarField {
 public:
 	void Init(int stars, int width);
@@ -39,17 +41,29 @@ public:
 private:
 	void SetUpGraphics();
 	void MakeStars(int stars, int width);
+	double Density(double area) const;
 	
 	
 private:
 	int widthMod;
 	int tileCols;
 	std::vector<int> tileIndex;
+	int maxTileStars;
 	
 	Shader shader;
 	GLuint vao;
 	GLuint vbo;
 	
+	// If the hardware supports it, the stars and the tile index are also
+	// exposed as buffer textures, so that every visible tile can be drawn in a
+	// single instanced draw call.
+	bool useInstancing;
+	Shader instancedShader;
+	GLuint instancedVao;
+	GLuint tileVbo;
+	GLuint starTexture;
+	GLuint tileTexture;
+	
 	GLuint offsetI;
 	GLuint sizeI;
 	GLuint cornerI;
@@ -58,6 +72,15 @@ private:
 	GLuint rotateI;
 	GLuint lengthI;
 	GLuint translateI;
+	
+	GLuint instancedScaleI;
+	GLuint instancedRotateI;
+	GLuint instancedLengthI;
+	GLuint instancedTranslateI;
+	GLuint firstTileI;
+	GLuint columnsI;
+	GLuint densityI;
+	GLuint patternColumnsI;
 };
 
 
@@ -0,0 +1,217 @@
+/* StartupProfile.cpp
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "StartupProfile.h"
+
+#include "Files.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+	// A phase that was timed, or a moment that was marked (if the duration is
+	// negative). All times are in microseconds since profiling started.
+	class Event {
+	public:
+		const char *name;
+		string detail;
+		int64_t start;
+		int64_t duration;
+		int thread;
+	};
+	
+	atomic<bool> isEnabled(false);
+	chrono::steady_clock::time_point startTime;
+	
+	mutex eventMutex;
+	vector<Event> events;
+	// Threads are numbered in the order they first record something.
+	map<thread::id, int> threadNumbers;
+	
+	
+	int64_t Now()
+	{
+		return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - startTime).count();
+	}
+	
+	
+	void Record(const char *name, const string &detail, int64_t start, int64_t duration)
+	{
+		lock_guard<mutex> lock(eventMutex);
+		int thread = threadNumbers.emplace(this_thread::get_id(), threadNumbers.size()).first->second;
+		events.push_back({name, detail, start, duration, thread});
+	}
+	
+	
+	// Write the given text as a JSON string, with any special characters escaped.
+	string Quote(const string &text)
+	{
+		string result = "\"";
+		for(char c : text)
+		{
+			if(c == '"' || c == '\\')
+				result += '\\';
+			if(static_cast<unsigned char>(c) >= ' ')
+				result += c;
+		}
+		return result + '"';
+	}
+	
+	
+	string Milliseconds(int64_t microseconds)
+	{
+		ostringstream out;
+		out << fixed << setprecision(1) << microseconds / 1000.;
+		return out.str();
+	}
+}
+
+
+
+StartupProfile::Phase::Phase(const char *name, const string &detail)
+	: name(name)
+{
+	if(!isEnabled)
+		return;
+	
+	this->detail = detail;
+	start = Now();
+}
+
+
+
+StartupProfile::Phase::~Phase()
+{
+	if(start >= 0 && isEnabled)
+		Record(name, detail, start, Now() - start);
+}
+
+
+
+// Begin profiling. Everything is timed relative to when this is called.
+void StartupProfile::Start()
+{
+	startTime = chrono::steady_clock::now();
+	isEnabled = true;
+}
+
+
+
+bool StartupProfile::IsEnabled()
+{
+	return isEnabled;
+}
+
+
+
+// Record that the given moment has been reached, e.g. the first frame.
+void StartupProfile::Mark(const char *name)
+{
+	if(isEnabled)
+		Record(name, "", Now(), -1);
+}
+
+
+
+// Stop profiling, print the summary table, and write the trace file.
+void StartupProfile::Finish()
+{
+	if(!isEnabled.exchange(false))
+		return;
+	
+	int64_t end = Now();
+	lock_guard<mutex> lock(eventMutex);
+	
+	// Add up all the events with the same name. They are listed in the order
+	// that each one first began.
+	class Total {
+	public:
+		int count = 0;
+		int64_t total = 0;
+		// Marks have no duration, so this stays negative for them.
+		int64_t longest = -1;
+		int64_t first = 0;
+		int64_t last = 0;
+	};
+	vector<const Event *> sorted;
+	for(const Event &event : events)
+		sorted.push_back(&event);
+	stable_sort(sorted.begin(), sorted.end(),
+		[](const Event *a, const Event *b) { return a->start < b->start; });
+	vector<string> names;
+	map<string, Total> totals;
+	for(const Event *event : sorted)
+	{
+		auto it = totals.find(event->name);
+		if(it == totals.end())
+		{
+			names.push_back(event->name);
+			it = totals.emplace(event->name, Total()).first;
+			it->second.first = event->start;
+		}
+		Total &total = it->second;
+		++total.count;
+		total.total += max<int64_t>(0, event->duration);
+		total.longest = max(total.longest, event->duration);
+		total.last = max(total.last, event->start + max<int64_t>(0, event->duration));
+	}
+	
+	// For each phase, "total" adds up the time spent in it on every thread,
+	// and "span" is from when it first began until it last ended.
+	cout << "phase" << '\t' << "count" << '\t' << "total ms" << '\t' << "longest ms"
+		<< '\t' << "started at ms" << '\t' << "span ms" << '\n';
+	for(const string &name : names)
+	{
+		const Total &total = totals[name];
+		if(total.longest < 0)
+			cout << name << '\t' << '\t' << '\t' << '\t' << Milliseconds(total.first) << '\n';
+		else
+			cout << name << '\t' << total.count << '\t' << Milliseconds(total.total)
+				<< '\t' << Milliseconds(total.longest) << '\t' << Milliseconds(total.first)
+				<< '\t' << Milliseconds(total.last - total.first) << '\n';
+	}
+	cout << "everything loaded" << '\t' << '\t' << '\t' << '\t' << Milliseconds(end) << '\n';
+	
+	string path = Files::Config() + "startup profile.json";
+	ostringstream out;
+	out << "{\"traceEvents\":[\n";
+	for(const Event *event : sorted)
+	{
+		out << "{\"name\":" << Quote(event->name) << ",\"pid\":1,\"tid\":" << event->thread
+			<< ",\"ts\":" << event->start;
+		if(event->duration < 0)
+			out << ",\"ph\":\"i\",\"s\":\"g\"";
+		else
+			out << ",\"ph\":\"X\",\"dur\":" << event->duration;
+		if(!event->detail.empty())
+			out << ",\"args\":{\"detail\":" << Quote(event->detail) << "}";
+		out << "},\n";
+	}
+	out << "{\"name\":\"everything loaded\",\"pid\":1,\"tid\":0,\"ts\":" << end << ",\"ph\":\"i\",\"s\":\"g\"}\n";
+	out << "]}\n";
+	Files::Write(path, out.str());
+	cout << "trace written to" << '\t' << path << '\n';
+	cout.flush();
+	
+	events.clear();
+	threadNumbers.clear();
+}
@@ -0,0 +1,60 @@
+/* StartupProfile.h
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef STARTUP_PROFILE_H_
+#define STARTUP_PROFILE_H_
+
+#include <cstdint>
+#include <string>
+
+
+
+// Class for measuring how long each phase of loading the game takes. It does
+// nothing unless the game is run with --profile-startup. Once everything has
+// finished loading, it prints a table of the total time spent in each phase,
+// and writes a trace of every phase (in the JSON format that chrome://tracing
+// understands) to the config folder. Phases may be timed from any thread.
+class StartupProfile {
+public:
+	// Object which times a phase from when it is created until it is destroyed.
+	// Phases that happen many times, e.g. decoding each sprite, are added up
+	// under the same name; the detail string distinguishes them in the trace.
+	class Phase {
+	public:
+		explicit Phase(const char *name, const std::string &detail = "");
+		Phase(const Phase &) = delete;
+		~Phase();
+		
+		Phase &operator=(const Phase &) = delete;
+	
+	private:
+		const char *name;
+		std::string detail;
+		int64_t start = -1;
+	};
+	
+	
+public:
+	// Begin profiling. Everything is timed relative to when this is called.
+	static void Start();
+	static bool IsEnabled();
+	
+	// Record that the given moment has been reached, e.g. the first frame.
+	static void Mark(const char *name);
+	
+	// Stop profiling, print the summary table, and write the trace file.
+	static void Finish();
+};
+
+
+
+#endif
@@ -16,15 +16,26 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Point.h"
 
 #include <cassert>
+#include <cstdint>
 #include <cstring>
+#include <map>
 
 using namespace std;
 
+namespace {
+	// Panels tend to re-wrap the same few descriptions over and over, so there
+	// is no need for anything smarter than throwing out the whole layout cache
+	// when it grows too large.
+	const size_t MAX_LAYOUTS = 1024;
+}
+
+map<string, shared_ptr<const WrappedText::Layout>> WrappedText::layoutCache;
+
 
 
 WrappedText::WrappedText()
 	: font(nullptr), space(0), wrapWidth(1000), tabWidth(0),
-	  lineHeight(0), paragraphBreak(0), alignment(JUSTIFIED), height(0)
+	  lineHeight(0), paragraphBreak(0), alignment(JUSTIFIED)
 {
 }
 
@@ -132,18 +143,14 @@ void WrappedText::SetParagraphBreak(int height)
 // always begin at (0, 0).
 void WrappedText::Wrap(const string &str)
 {
-	SetText(str.data(), str.length());
-	
-	Wrap();
+	Wrap(str.data(), str.length());
 }
 
 
 
 void WrappedText::Wrap(const char *str)
 {
-	SetText(str, strlen(str));
-	
-	Wrap();
+	Wrap(str, strlen(str));
 }
 
 
@@ -151,7 +158,7 @@ void WrappedText::Wrap(const char *str)
 // Get the height of the wrapped text.
 int WrappedText::Height() const
 {
-	return height;
+	return layout ? layout->height : 0;
 }
 
 
@@ -159,8 +166,8 @@ int WrappedText::Height() const
 // Draw the text.
 void WrappedText::Draw(const Point &topLeft, const Color &color) const
 {
-	for(const Word &w : words)
-		font->Draw(text.c_str() + w.Index(), w.Pos() + topLeft, color);
+	if(layout && !layout->block.empty())
+		font->DrawBlock(layout->blockKey, layout->block, topLeft, color);
 }
 
 
@@ -186,19 +193,46 @@ Point WrappedText::Word::Pos() const
 
 
 
-void WrappedText::SetText(const char *it, size_t length)
+// Look up the layout of the given text with the current settings, only doing
+// the actual word wrapping if no other WrappedText has already done so.
+void WrappedText::Wrap(const char *it, size_t length)
 {
-	// Clear any previous word-wrapping data. It becomes invalid as soon as the
-	// underlying text buffer changes.
-	words.clear();
+	assert(font);
+	
+	// The key packs in every setting that affects the layout, followed by the
+	// text itself.
+	int settings[] = {wrapWidth, tabWidth, lineHeight, paragraphBreak, alignment, space};
+	uintptr_t fontID = reinterpret_cast<uintptr_t>(font);
+	string key(reinterpret_cast<const char *>(&fontID), sizeof(fontID));
+	key.append(reinterpret_cast<const char *>(settings), sizeof(settings));
+	key.append(it, length);
+	
+	auto cit = layoutCache.find(key);
+	if(cit != layoutCache.end())
+	{
+		layout = cit->second;
+		return;
+	}
+	
+	shared_ptr<Layout> result(new Layout);
+	result->text.assign(it, length);
+	Wrap(*result);
+	
+	// Font block keys must begin with a null character. The rest of this key
+	// need not include the font, since each font has its own cache.
+	result->blockKey = '\0' + key.substr(sizeof(fontID));
+	for(const Word &w : result->words)
+		result->block.emplace_back(w.Pos(), result->text.c_str() + w.Index());
 	
-	// Reallocate that buffer.
-	text.assign(it, length);
+	if(layoutCache.size() >= MAX_LAYOUTS)
+		layoutCache.clear();
+	layoutCache[key] = result;
+	layout = result;
 }
 
 
 
-void WrappedText::Wrap()
+void WrappedText::Wrap(Layout &layout) const
 {
 	assert(font);
 	
@@ -218,6 +252,8 @@ void WrappedText::Wrap()
 	// would require a different format for the buffer, though, because it means
 	// inserting '\0' characters even where there is no whitespace.
 	
+	string &text = layout.text;
+	vector<Word> &words = layout.words;
 	for(string::iterator it = text.begin(); it != text.end(); ++it)
 	{
 		char c = *it;
@@ -236,7 +272,7 @@ void WrappedText::Wrap()
 				word.y += lineHeight;
 				word.x = 0;
 				
-				AdjustLine(lineBegin, lineWidth, false);
+				AdjustLine(layout, lineBegin, lineWidth, false);
 			}
 			// Store this word, then advance the x position to the end of it.
 			words.push_back(word);
@@ -253,7 +289,7 @@ void WrappedText::Wrap()
 			word.y += lineHeight + paragraphBreak;
 			word.x = 0;
 			
-			AdjustLine(lineBegin, lineWidth, true);
+			AdjustLine(layout, lineBegin, lineWidth, true);
 		}
 		// Otherwise, whitespace just adds to the x position.
 		else if(c <= ' ')
@@ -277,20 +313,21 @@ void WrappedText::Wrap()
 			word.y += lineHeight;
 			word.x = 0;
 			
-			AdjustLine(lineBegin, lineWidth, false);
+			AdjustLine(layout, lineBegin, lineWidth, false);
 		}
 		words.push_back(word);
 		word.y += lineHeight + paragraphBreak;
 	}
-	AdjustLine(lineBegin, lineWidth, true);
+	AdjustLine(layout, lineBegin, lineWidth, true);
 	
-	height = word.y;
+	layout.height = word.y;
 }
 
 
 
-void WrappedText::AdjustLine(unsigned &lineBegin, int &lineWidth, bool isEnd)
+void WrappedText::AdjustLine(Layout &layout, unsigned &lineBegin, int &lineWidth, bool isEnd) const
 {
+	vector<Word> &words = layout.words;
 	int wordCount = words.size() - lineBegin;
 	int extraSpace = wrapWidth - lineWidth;
 	
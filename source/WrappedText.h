@@ -15,7 +15,10 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Point.h"
 
+#include <map>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 class Color;
@@ -24,7 +27,9 @@ class Font;
 
 
 // Class for calculating word positions in wrapped text. You can specify various
-// parameters of the formatting, including text alignment.
+// parameters of the formatting, including text alignment. Layouts are cached and
+// shared, so wrapping the same text with the same settings again is cheap, and
+// the wrapped text is drawn as a single block of glyphs.
 class WrappedText {
 public:
 	WrappedText();
@@ -56,7 +61,8 @@ public:
 	int ParagraphBreak() const;
 	void SetParagraphBreak(int height);
 	
-	// Wrap the given text. Use Draw() to draw it.
+	// Wrap the given text. Use Draw() to draw it. Changing any of the settings
+	// above has no effect until the text is wrapped again.
 	void Wrap(const std::string &str);
 	void Wrap(const char *str);
 	
@@ -68,9 +74,10 @@ public:
 	
 	
 private:
-	void SetText(const char *it, size_t length);
-	void Wrap();
-	void AdjustLine(unsigned &lineBegin, int &lineWidth, bool isEnd);
+	class Layout;
+	void Wrap(const char *it, size_t length);
+	void Wrap(Layout &layout) const;
+	void AdjustLine(Layout &layout, unsigned &lineBegin, int &lineWidth, bool isEnd) const;
 	int Space(char c) const;
 	
 	
@@ -91,6 +98,20 @@ private:
 		friend class WrappedText;
 	};
 	
+	// The result of wrapping a particular string with particular settings.
+	class Layout {
+	public:
+		// The text, with a '\0' inserted at the end of each word.
+		std::string text;
+		std::vector<Word> words;
+		int height = 0;
+		
+		// The words and their positions, in the form that Font draws them, and
+		// the key identifying this block of words in the font's cache.
+		std::vector<std::pair<Point, const char *>> block;
+		std::string blockKey;
+	};
+	
 	
 private:
 	const Font *font;
@@ -102,9 +123,11 @@ private:
 	int paragraphBreak;
 	Align alignment;
 	
-	std::string text;
-	std::vector<Word> words;
-	int height;
+	std::shared_ptr<const Layout> layout;
+	
+	// Layouts shared by every WrappedText, keyed by the font, the formatting
+	// settings, and the text itself.
+	static std::map<std::string, std::shared_ptr<const Layout>> layoutCache;
 };
 
 
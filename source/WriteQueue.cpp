@@ -0,0 +1,98 @@
+/* WriteQueue.cpp
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "WriteQueue.h"
+
+#include "Files.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+using namespace std;
+
+namespace {
+	mutex queueMutex;
+	condition_variable doneCondition;
+	queue<function<void()>> tasks;
+	// The thread only runs while there is something in the queue for it to do.
+	bool isRunning = false;
+	thread worker;
+	
+	
+	void Work()
+	{
+		unique_lock<mutex> lock(queueMutex);
+		while(!tasks.empty())
+		{
+			function<void()> task = move(tasks.front());
+			// Unlock the mutex while writing, so more tasks can be added.
+			lock.unlock();
+			task();
+			lock.lock();
+			tasks.pop();
+		}
+		isRunning = false;
+		doneCondition.notify_all();
+	}
+	
+	
+	void Push(function<void()> task)
+	{
+		lock_guard<mutex> lock(queueMutex);
+		tasks.push(move(task));
+		if(isRunning)
+			return;
+		
+		// If a previous thread emptied the queue, it has already finished.
+		if(worker.joinable())
+			worker.join();
+		isRunning = true;
+		worker = thread(&Work);
+	}
+	
+	
+	// If the game exits without calling Wait(), still finish writing.
+	class Finisher {
+	public:
+		~Finisher() { WriteQueue::Wait(); }
+	} finisher;
+}
+
+
+
+// Write the given data to the given path.
+void WriteQueue::Add(const string &path, string data)
+{
+	Push(bind(&Files::Replace, path, move(data)));
+}
+
+
+
+// Do the given task once every file added before it has been written.
+void WriteQueue::Then(const function<void()> &task)
+{
+	Push(task);
+}
+
+
+
+// Wait until everything that has been queued is done.
+void WriteQueue::Wait()
+{
+	unique_lock<mutex> lock(queueMutex);
+	while(isRunning)
+		doneCondition.wait(lock);
+	if(worker.joinable())
+		worker.join();
+}
@@ -0,0 +1,41 @@
+/* WriteQueue.h
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef WRITE_QUEUE_H_
+#define WRITE_QUEUE_H_
+
+#include <functional>
+#include <string>
+
+
+
+// Class which writes files in a background thread, so that the game does not
+// pause each time the player's game is saved. Each file is written with
+// Files::Replace(), so the previous copy of it is kept intact until the new
+// one is completely written. Everything that is queued is done in the order
+// that it was added, one thing at a time.
+class WriteQueue {
+public:
+	// Write the given data to the given path.
+	static void Add(const std::string &path, std::string data);
+	// Do the given task once every file added before it has been written.
+	static void Then(const std::function<void()> &task);
+	
+	// Wait until everything that has been queued is done. This must be called
+	// before reading any file that might still be waiting to be written, and
+	// before the game exits.
+	static void Wait();
+};
+
+
+
+#endif
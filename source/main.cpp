@@ -18,7 +18,6 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "ConversationPanel.h"
 #include "DataFile.h"
 #include "DataNode.h"
-#include "Dialog.h"
 #include "Font.h"
 #include "FrameTimer.h"
 #include "GameData.h"
@@ -27,12 +26,13 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "PlayerInfo.h"
 #include "Preferences.h"
 #include "Screen.h"
+#include "StartupProfile.h"
 #include "UI.h"
+#include "WriteQueue.h"
 
 #include "gl_header.h"
 #include <SDL2/SDL.h>
 
-#include <cstring>
 #include <iostream>
 #include <map>
 #include <sstream>
@@ -57,6 +57,9 @@ int main(int argc, char *argv[])
 {
 	Conversation conversation;
 	bool debugMode = false;
+	bool printMemoryReport = false;
+	bool cookImages = false;
+	bool compress = false;
 	for(const char *const *it = argv + 1; *it; ++it)
 	{
 		string arg = *it;
@@ -74,6 +77,20 @@ int main(int argc, char *argv[])
 			conversation = LoadConversation();
 		else if(arg == "-d" || arg == "--debug")
 			debugMode = true;
+		else if(arg == "--memory-report")
+			printMemoryReport = true;
+		else if(arg == "--profile-startup")
+			StartupProfile::Start();
+		else if(arg == "--cook")
+			cookImages = true;
+		else if(arg == "--compress")
+			compress = true;
+	}
+	// Cooking the images does not need a window, so do it and then quit.
+	if(cookImages)
+	{
+		GameData::CookImages(argv, compress);
+		return 0;
 	}
 	PlayerInfo player;
 	
@@ -81,8 +98,14 @@ int main(int argc, char *argv[])
 		SDL_Init(SDL_INIT_VIDEO);
 		
 		// Begin loading the game data.
-		GameData::BeginLoad(argv);
-		Audio::Init(GameData::Sources());
+		{
+			StartupProfile::Phase phase("GameData::BeginLoad");
+			GameData::BeginLoad(argv);
+		}
+		{
+			StartupProfile::Phase phase("Audio::Init");
+			Audio::Init(GameData::Sources());
+		}
 		
 		// On Windows, make sure that the sleep timer has at least 1 ms resolution
 		// to avoid irregular frame rates.
@@ -90,8 +113,13 @@ int main(int argc, char *argv[])
 		timeBeginPeriod(1);
 #endif
 		
-		player.LoadRecent();
-		player.ApplyChanges();
+		{
+			StartupProfile::Phase phase("PlayerInfo::LoadRecent");
+			player.LoadRecent();
+			player.ApplyChanges();
+			// Now that the player is known, load what they will see first.
+			GameData::Prioritize(player);
+		}
 		
 		// Check how big the window can be.
 		SDL_DisplayMode mode;
@@ -191,7 +219,11 @@ int main(int argc, char *argv[])
 		glDisable(GL_DEPTH_TEST);
 		glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 		
-		GameData::LoadShaders();
+		StartupProfile::Mark("window created");
+		{
+			StartupProfile::Phase phase("GameData::LoadShaders");
+			GameData::LoadShaders();
+		}
 		
 		{
 			// Check whether this is a high-DPI window.
@@ -199,6 +231,8 @@ int main(int argc, char *argv[])
 			int height = 0;
 			SDL_GL_GetDrawableSize(window, &width, &height);
 			Screen::SetHighDPI(width > Screen::RawWidth() && height > Screen::RawHeight());
+			if(Screen::IsHighResolution())
+				GameData::LoadHighDPI();
 			
 			// Fix a possible race condition leading to the wrong window dimensions.
 			glViewport(0, 0, width, height);
@@ -211,29 +245,9 @@ int main(int argc, char *argv[])
 		if(!conversation.IsEmpty())
 			menuPanels.Push(new ConversationPanel(player, conversation));
 		
-		string swizzleName = "_texture_swizzle";
-#ifndef __APPLE__
-		const char *extensions = reinterpret_cast<const char *>(glGetString(GL_EXTENSIONS));
-		if(!strstr(extensions, swizzleName.c_str()))
-#else
-		bool hasSwizzle = false;
-		GLint extensionCount;
-		glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
-		for(GLint i = 0; i < extensionCount && !hasSwizzle; ++i)
-		{
-			const char *extension = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i));
-			hasSwizzle = (extension && strstr(extension, swizzleName.c_str()));
-		}
-		if(!hasSwizzle)
-#endif
-			menuPanels.Push(new Dialog(
-				"Note: your computer does not support the \"texture swizzling\" OpenGL feature, "
-				"which Endless Sky uses to draw ships in different colors depending on which "
-				"government they belong to. So, all human ships will be the same color, which "
-				"may be confusing. Consider upgrading your graphics driver (or your OS)."));
-		
 		FrameTimer timer(60);
 		bool isPaused = false;
+		bool hasDrawnFrame = false;
 		while(!menuPanels.IsDone())
 		{
 			// Handle any events that occurred in this frame.
@@ -310,13 +324,39 @@ int main(int argc, char *argv[])
 			// Tell all the panels to step forward, then draw them.
 			((!isPaused && menuPanels.IsEmpty()) ? gamePanels : menuPanels).StepAll();
 			Audio::Step();
+			// Once a game has begun, the main panel reloads changed files and
+			// loads or unloads sprites when it is safe to do so. Before that,
+			// nothing else is using the game data.
+			if(gamePanels.IsEmpty())
+			{
+				GameData::ReloadChanges();
+				GameData::StepSprites();
+			}
 			// That may have cleared out the menu, in which case we should draw
 			// the game panels instead:
 			(menuPanels.IsEmpty() ? gamePanels : menuPanels).DrawAll();
 			
+			// Once everything has loaded, report how much memory it is using.
+			if(printMemoryReport && GameData::Progress() == 1.)
+			{
+				Audio::PrintMemoryReport();
+				GameData::PrintSpriteReport();
+				printMemoryReport = false;
+			}
+			
 			SDL_GL_SwapWindow(window);
+			if(!hasDrawnFrame)
+			{
+				StartupProfile::Mark("first menu frame");
+				hasDrawnFrame = true;
+			}
+			// Once everything has loaded, report how long each part of it took.
+			if(StartupProfile::IsEnabled() && GameData::Progress() == 1.)
+				StartupProfile::Finish();
 			timer.Wait();
 		}
+		// If the game quit before everything was loaded, report what did load.
+		StartupProfile::Finish();
 		
 		// If you quit while landed on a planet, save the game.
 		if(player.GetPlanet())
@@ -329,6 +369,12 @@ int main(int argc, char *argv[])
 		if(isFullscreen)
 			Screen::SetRaw(restoreWidth, restoreHeight);
 		Preferences::Save();
+		// Don't quit until the game has finished saving.
+		WriteQueue::Wait();
+		
+		// Also catch any bad names that were only looked up during play.
+		if(debugMode)
+			GameData::CheckReferences();
 		
 		Cleanup(window, context);
 	}
@@ -353,7 +399,16 @@ void PrintHelp()
 	cerr << "    -t, --talk: read and display a conversation from STDIN." << endl;
 	cerr << "    -r, --resources <path>: load resources from given directory." << endl;
 	cerr << "    -c, --config <path>: save user's files to given directory." << endl;
-	cerr << "    -d, --debug: turn on debugging features (e.g. caps lock slow motion)." << endl;
+	cerr << "    -d, --debug: turn on debugging features (e.g. caps lock slow motion, and on Linux," << endl;
+	cerr << "        reloading data files and images when they are changed)." << endl;
+	cerr << "    --memory-report: print the memory used by game assets once loaded." << endl;
+	cerr << "    --loader-threads <count>: set how many threads load images (default: one per core)." << endl;
+	cerr << "    --texture-budget <megabytes>: unload unused sprites above this size (default: 512, 0 for no limit)." << endl;
+	cerr << "    --no-data-cache: always parse the data files instead of using the cached copy." << endl;
+	cerr << "    --verify-data-cache: check that the cached data matches the data files." << endl;
+	cerr << "    --profile-startup: print how long each part of loading takes, and save a trace of it." << endl;
+	cerr << "    --cook: convert all images into ready-to-upload textures, then quit." << endl;
+	cerr << "    --compress: with --cook, also block compress the larger textures." << endl;
 	cerr << endl;
 	cerr << "Report bugs to: mzahniser@gmail.com" << endl;
 	cerr << "Home page: <https://endless-sky.github.io>" << endl;
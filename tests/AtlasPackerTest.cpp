@@ -0,0 +1,164 @@
+/* AtlasPackerTest.cpp
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Test.h"
+
+#include "AtlasPacker.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+	const int PAGE_SIZE = 512;
+	const int PADDING = 1;
+	
+	
+	string Describe(const AtlasPacker::Slot &slot)
+	{
+		return "page " + to_string(slot.page) + " (" + to_string(slot.x) + ", " + to_string(slot.y)
+			+ ") " + to_string(slot.width) + "x" + to_string(slot.height);
+	}
+	
+	
+	// Check that the given slot, including the padding around it, is within
+	// the bounds of its page.
+	void CheckBounds(const AtlasPacker::Slot &slot)
+	{
+		bool inside = (slot.page >= 0 && slot.x - PADDING >= 0 && slot.y - PADDING >= 0
+			&& slot.x + slot.width + PADDING <= PAGE_SIZE && slot.y + slot.height + PADDING <= PAGE_SIZE);
+		Test::Check(inside, "slot is out of bounds: " + Describe(slot));
+	}
+	
+	
+	// Check that no two slots that are in use overlap, including their padding.
+	void CheckOverlaps(const vector<AtlasPacker::Slot> &slots)
+	{
+		for(size_t i = 0; i < slots.size(); ++i)
+			for(size_t j = i + 1; j < slots.size(); ++j)
+			{
+				const AtlasPacker::Slot &a = slots[i];
+				const AtlasPacker::Slot &b = slots[j];
+				bool separate = (a.page != b.page
+					|| a.x + a.width + PADDING <= b.x - PADDING || b.x + b.width + PADDING <= a.x - PADDING
+					|| a.y + a.height + PADDING <= b.y - PADDING || b.y + b.height + PADDING <= a.y - PADDING);
+				Test::Check(separate, "slots overlap: " + Describe(a) + " and " + Describe(b));
+			}
+	}
+	
+	
+	// Add images of random sizes, and check every slot that is handed out.
+	vector<AtlasPacker::Slot> Fill(AtlasPacker &packer, mt19937 &random, int count)
+	{
+		// Most images in the game come in groups of similar sizes, but make sure
+		// the packer also copes with images of very different shapes.
+		uniform_int_distribution<int> size(1, 128);
+		vector<AtlasPacker::Slot> slots;
+		for(int i = 0; i < count; ++i)
+		{
+			AtlasPacker::Slot slot;
+			int width = size(random);
+			int height = size(random);
+			bool added = packer.Add(width, height, slot);
+			Test::Check(added, "unable to add a " + to_string(width) + "x" + to_string(height) + " image");
+			if(!added)
+				continue;
+			
+			Test::Check(slot.width == width && slot.height == height, "slot has the wrong size: " + Describe(slot));
+			CheckBounds(slot);
+			slots.push_back(slot);
+		}
+		return slots;
+	}
+	
+	
+	void TestPacking()
+	{
+		mt19937 random(1);
+		AtlasPacker packer(PAGE_SIZE, PADDING);
+		vector<AtlasPacker::Slot> slots = Fill(packer, random, 400);
+		CheckOverlaps(slots);
+		
+		Test::Check(packer.Pages() > 1, "400 images should need more than one page");
+		int total = 0;
+		for(int i = 0; i < packer.Pages(); ++i)
+			total += packer.Count(i);
+		Test::Check(total == static_cast<int>(slots.size()), "pages do not count every slot");
+	}
+	
+	
+	void TestLimits()
+	{
+		AtlasPacker packer(PAGE_SIZE, PADDING);
+		AtlasPacker::Slot slot;
+		Test::Check(!packer.Add(0, 10, slot), "an empty image should not be added");
+		Test::Check(!packer.Add(PAGE_SIZE, 10, slot), "an image too wide to pad should not be added");
+		Test::Check(!packer.Add(10, PAGE_SIZE - 1, slot), "an image too tall to pad should not be added");
+		Test::Check(!packer.Pages(), "a page was added for an image that did not fit");
+		
+		// The largest image that fits fills an entire page by itself.
+		Test::Check(packer.Add(PAGE_SIZE - 2 * PADDING, PAGE_SIZE - 2 * PADDING, slot), "unable to add a full page image");
+		CheckBounds(slot);
+		AtlasPacker::Slot next;
+		Test::Check(packer.Add(1, 1, next) && next.page == 1, "a full page should not fit anything else");
+	}
+	
+	
+	void TestReuse()
+	{
+		mt19937 random(2);
+		AtlasPacker packer(PAGE_SIZE, PADDING);
+		vector<AtlasPacker::Slot> slots = Fill(packer, random, 300);
+		int pages = packer.Pages();
+		
+		// Free every slot on the first page, and only some of the slots on the
+		// others. Only the first page's space can be reclaimed.
+		vector<AtlasPacker::Slot> kept;
+		for(size_t i = 0; i < slots.size(); ++i)
+		{
+			if(!slots[i].page || i % 2)
+				packer.Remove(slots[i]);
+			else
+				kept.push_back(slots[i]);
+		}
+		Test::Check(!packer.Count(0), "the first page should be empty");
+		// Removing a slot again must not corrupt the count of a page.
+		packer.Remove(slots.front());
+		Test::Check(!packer.Count(0), "removing a slot twice changed its page's count");
+		
+		// New images go on the page that was emptied, without adding pages. The
+		// emptied page has room for 25 of these images.
+		for(int i = 0; i < 16; ++i)
+		{
+			AtlasPacker::Slot slot;
+			Test::Check(packer.Add(100, 100, slot), "unable to add an image to the emptied page");
+			Test::Check(!slot.page, "an image was not placed on the emptied page: " + Describe(slot));
+			CheckBounds(slot);
+			kept.push_back(slot);
+		}
+		Test::Check(packer.Count(0) == 16, "the emptied page does not count its new slots");
+		Test::Check(packer.Pages() == pages, "a page was added even though one was empty");
+		CheckOverlaps(kept);
+	}
+}
+
+
+
+int main()
+{
+	TestPacking();
+	TestLimits();
+	TestReuse();
+	return Test::Result("AtlasPackerTest");
+}
@@ -0,0 +1,166 @@
+/* BlockCompressorTest.cpp
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Test.h"
+
+#include "BlockCompressor.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+	// A color that 5:6:5 bits can store exactly.
+	const uint32_t EXACT = 0xFF8410FFu;
+	
+	
+	uint32_t Pixel(int r, int g, int b, int a)
+	{
+		return (static_cast<uint32_t>(a) << 24) | (r << 16) | (g << 8) | b;
+	}
+	
+	
+	int Channel(uint32_t pixel, int shift)
+	{
+		return (pixel >> shift) & 0xFF;
+	}
+	
+	
+	// Check that every channel of every decoded pixel is within the given
+	// tolerance of the original. Alpha is checked separately, since BC1 and BC3
+	// store it with very different precision.
+	void Compare(const string &name, const vector<uint32_t> &original, const vector<uint32_t> &decoded,
+		int colorTolerance, int alphaTolerance)
+	{
+		Test::Check(original.size() == decoded.size(), name + ": decoded image has the wrong size");
+		for(size_t i = 0; i < original.size() && i < decoded.size(); ++i)
+		{
+			for(int shift : {16, 8, 0})
+			{
+				int error = abs(Channel(original[i], shift) - Channel(decoded[i], shift));
+				Test::Check(error <= colorTolerance, name + ": pixel " + to_string(i) + " color is off by "
+					+ to_string(error));
+			}
+			int error = abs(Channel(original[i], 24) - Channel(decoded[i], 24));
+			Test::Check(error <= alphaTolerance, name + ": pixel " + to_string(i) + " alpha is off by "
+				+ to_string(error));
+		}
+	}
+	
+	
+	void RoundTripBC1(const string &name, const vector<uint32_t> &pixels, int width, int height, int tolerance)
+	{
+		vector<uint8_t> blocks;
+		BlockCompressor::EncodeBC1(pixels.data(), width, height, blocks);
+		Test::Check(blocks.size() == BlockCompressor::BC1Size(width, height), name + ": wrong compressed size");
+		
+		vector<uint32_t> decoded(pixels.size());
+		BlockCompressor::DecodeBC1(blocks.data(), width, height, decoded.data());
+		Compare(name, pixels, decoded, tolerance, 0);
+	}
+	
+	
+	void RoundTripBC3(const string &name, const vector<uint32_t> &pixels, int width, int height,
+		int colorTolerance, int alphaTolerance)
+	{
+		vector<uint8_t> blocks;
+		BlockCompressor::EncodeBC3(pixels.data(), width, height, blocks);
+		Test::Check(blocks.size() == BlockCompressor::BC3Size(width, height), name + ": wrong compressed size");
+		
+		vector<uint32_t> decoded(pixels.size());
+		BlockCompressor::DecodeBC3(blocks.data(), width, height, decoded.data());
+		Compare(name, pixels, decoded, colorTolerance, alphaTolerance);
+	}
+	
+	
+	void TestSolid()
+	{
+		// A solid block of a color that 5:6:5 can represent must survive exactly.
+		vector<uint32_t> exact(16, EXACT);
+		RoundTripBC1("solid BC1", exact, 4, 4, 0);
+		RoundTripBC3("solid BC3", exact, 4, 4, 0, 0);
+		
+		// Any other solid color is only off by the 5:6:5 rounding.
+		vector<uint32_t> solid(16, Pixel(200, 100, 37, 255));
+		RoundTripBC1("rounded solid BC1", solid, 4, 4, 4);
+		
+		// An image that is not a multiple of four in size is padded.
+		vector<uint32_t> odd(7 * 5, EXACT);
+		RoundTripBC1("odd size BC1", odd, 7, 5, 0);
+		RoundTripBC3("odd size BC3", odd, 7, 5, 0, 0);
+	}
+	
+	
+	void TestTwoColors()
+	{
+		// In a block with only two colors in it, each pixel should be one of the
+		// end points. The encoder pulls its end points in by 1/16 of the range
+		// of each channel, so each pixel may be off by that plus the 5:6:5
+		// rounding (which is at most 4 for a channel with five bits).
+		vector<uint32_t> pixels;
+		for(int i = 0; i < 16; ++i)
+			pixels.push_back((i * 7) % 3 ? Pixel(255, 0, 0, 255) : Pixel(0, 0, 255, 255));
+		RoundTripBC1("two color BC1", pixels, 4, 4, 255 / 16 + 4);
+		RoundTripBC3("two color BC3", pixels, 4, 4, 255 / 16 + 4, 0);
+		
+		// A larger image made of blocks of different pairs of colors.
+		vector<uint32_t> image;
+		for(int y = 0; y < 8; ++y)
+			for(int x = 0; x < 8; ++x)
+			{
+				bool first = (x + y) % 2;
+				int block = (x / 4) + 2 * (y / 4);
+				image.push_back(first ? Pixel(40 * block, 255, 0, 255) : Pixel(0, 60 * block, 255 - 40 * block, 255));
+			}
+		RoundTripBC1("two color blocks BC1", image, 8, 8, 255 / 16 + 4);
+	}
+	
+	
+	void TestAlphaGradient()
+	{
+		// A gradient from transparent to opaque across the block. BC3 stores the
+		// alpha end points exactly and interpolates six values between them, so
+		// no pixel is more than half of a step (255 / 7 / 2) from its original.
+		vector<uint32_t> pixels;
+		for(int i = 0; i < 16; ++i)
+			pixels.push_back((static_cast<uint32_t>(i * 17) << 24) | (EXACT & 0xFFFFFFu));
+		RoundTripBC3("alpha gradient BC3", pixels, 4, 4, 0, 19);
+		
+		// The ends of the gradient must be exact, so that fully transparent and
+		// fully opaque pixels stay that way.
+		vector<uint8_t> blocks;
+		BlockCompressor::EncodeBC3(pixels.data(), 4, 4, blocks);
+		vector<uint32_t> decoded(16);
+		BlockCompressor::DecodeBC3(blocks.data(), 4, 4, decoded.data());
+		Test::Check(Channel(decoded.front(), 24) == 0, "alpha gradient BC3: transparent end is not exact");
+		Test::Check(Channel(decoded.back(), 24) == 255, "alpha gradient BC3: opaque end is not exact");
+		
+		// A gradient over only part of the range is stored more precisely.
+		vector<uint32_t> narrow;
+		for(int i = 0; i < 16; ++i)
+			narrow.push_back((static_cast<uint32_t>(100 + 2 * i) << 24) | (EXACT & 0xFFFFFFu));
+		RoundTripBC3("narrow alpha gradient BC3", narrow, 4, 4, 0, 3);
+	}
+}
+
+
+
+int main()
+{
+	TestSolid();
+	TestTwoColors();
+	TestAlphaGradient();
+	return Test::Result("BlockCompressorTest");
+}
@@ -0,0 +1,108 @@
+/* ImageBufferTest.cpp
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Test.h"
+
+#include "ImageBuffer.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+	const char *MODE[3] = {"normal", "half-additive", "additive"};
+	
+	
+	string Hex(uint32_t value)
+	{
+		static const char DIGITS[] = "0123456789ABCDEF";
+		string result(8, '0');
+		for(int i = 7; i >= 0; --i, value >>= 4)
+			result[i] = DIGITS[value & 15];
+		return result;
+	}
+	
+	
+	// Convert the given pixels with both the vector and the scalar code, in rows
+	// of the given width, and check that every pixel comes out the same. Rows
+	// whose width is not a multiple of the vector size also exercise the code
+	// that handles the pixels left over at the end of each row.
+	void Compare(const vector<uint32_t> &pixels, int width, int additive)
+	{
+		vector<uint32_t> vectorized = pixels;
+		vector<uint32_t> scalar = pixels;
+		for(size_t start = 0; start < pixels.size(); start += width)
+		{
+			size_t end = min(pixels.size(), start + width);
+			ImageBuffer::PremultiplyRow(&vectorized[start], &vectorized[0] + end, additive);
+			ImageBuffer::PremultiplyRowScalar(&scalar[start], &scalar[0] + end, additive);
+		}
+		
+		for(size_t i = 0; i < pixels.size(); ++i)
+			Test::Check(vectorized[i] == scalar[i], string(MODE[additive]) + " pixel " + Hex(pixels[i]) + " became "
+				+ Hex(vectorized[i]) + " instead of " + Hex(scalar[i]) + " (row width " + to_string(width) + ")");
+	}
+	
+	
+	// Every combination of alpha and channel value. Each channel of a pixel has
+	// a different value, so a mix-up between channels would also be caught.
+	void TestExhaustive()
+	{
+		vector<uint32_t> pixels;
+		for(uint32_t alpha = 0; alpha < 256; ++alpha)
+			for(uint32_t value = 0; value < 256; ++value)
+				pixels.push_back((alpha << 24) | (value << 16) | ((255 - value) << 8) | ((value * 97) & 255));
+		
+		for(int additive = 0; additive < 3; ++additive)
+			for(int width : {4096, 8, 1, 3, 7, 13, 17})
+				Compare(pixels, width, additive);
+	}
+	
+	
+	void TestRandom()
+	{
+		mt19937 random(1);
+		vector<uint32_t> pixels(100000);
+		for(uint32_t &pixel : pixels)
+			pixel = random();
+		
+		for(int additive = 0; additive < 3; ++additive)
+			for(int width : {1000, 5, 9, 11, 31})
+				Compare(pixels, width, additive);
+	}
+	
+	
+	// Spot check the scalar code against values worked out by hand, so that
+	// the comparison above is not just checking that both are wrong the same way.
+	void TestKnownValues()
+	{
+		uint32_t pixels[3] = {0x80FF4020u, 0x80FF4020u, 0x80FF4020u};
+		for(int additive = 0; additive < 3; ++additive)
+			ImageBuffer::PremultiplyRowScalar(pixels + additive, pixels + additive + 1, additive);
+		Test::Check(pixels[0] == 0x80802010u, "normal premultiply gives " + Hex(pixels[0]));
+		Test::Check(pixels[1] == 0x20802010u, "half-additive premultiply gives " + Hex(pixels[1]));
+		Test::Check(pixels[2] == 0x00802010u, "additive premultiply gives " + Hex(pixels[2]));
+	}
+}
+
+
+
+int main()
+{
+	TestKnownValues();
+	TestExhaustive();
+	TestRandom();
+	return Test::Result("ImageBufferTest");
+}
@@ -0,0 +1,56 @@
+/* Test.h
+Copyright (c) 2016 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef TEST_H_
+#define TEST_H_
+
+#include <iostream>
+#include <string>
+
+
+
+// Each unit test is a separate program that checks one part of the game which
+// can be run without a window or an OpenGL context. A test reports every check
+// that fails, and returns a nonzero exit code if any of them did. To keep the
+// output readable, only the first few failures of each kind are printed.
+class Test {
+public:
+	// Record the result of one check.
+	static void Check(bool passed, const std::string &message)
+	{
+		++checks;
+		if(passed)
+			return;
+		
+		if(++failures <= 20)
+			std::cerr << "FAILED: " << message << std::endl;
+	}
+	
+	// Report the results, and get the exit code for the test program.
+	static int Result(const std::string &name)
+	{
+		std::cerr << name << ": " << (checks - failures) << " of " << checks << " checks passed." << std::endl;
+		return failures ? 1 : 0;
+	}
+	
+	
+private:
+	static int checks;
+	static int failures;
+};
+
+int Test::checks = 0;
+int Test::failures = 0;
+
+
+
+#endif